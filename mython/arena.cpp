@@ -0,0 +1,94 @@
+#include "arena.h"
+
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+namespace arena {
+
+namespace {
+
+// Размеры округляются до кратных ALIGNMENT, каждому кратному - своя корзина
+constexpr size_t ALIGNMENT = alignof(max_align_t);
+constexpr size_t MAX_POOLED_SIZE = 256;
+constexpr size_t BUCKET_COUNT = MAX_POOLED_SIZE / ALIGNMENT;
+// Память запрашивается у кучи крупными блоками
+constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+// Освобождённые блоки связываются в список прямо в собственной памяти
+struct FreeNode {
+    FreeNode* next;
+};
+
+class Pool {
+public:
+    void* Allocate(size_t size) {
+        const size_t bucket = BucketFor(size);
+
+        if (auto*& head = buckets_[bucket]) {
+            void* ptr = head;
+            head = head->next;
+            return ptr;
+        }
+
+        const size_t need = (bucket + 1) * ALIGNMENT;
+
+        if (static_cast<size_t>(chunk_end_ - chunk_pos_) < need) {
+            chunks_.push_back(make_unique<char[]>(CHUNK_SIZE));
+            chunk_pos_ = chunks_.back().get();
+            chunk_end_ = chunk_pos_ + CHUNK_SIZE;
+        }
+
+        void* ptr = chunk_pos_;
+        chunk_pos_ += need;
+        return ptr;
+    }
+
+    void Deallocate(void* ptr, size_t size) noexcept {
+        const size_t bucket = BucketFor(size);
+        auto* node = static_cast<FreeNode*>(ptr);
+        node->next = buckets_[bucket];
+        buckets_[bucket] = node;
+    }
+
+private:
+    static size_t BucketFor(size_t size) noexcept {
+        return (size + ALIGNMENT - 1) / ALIGNMENT - 1;
+    }
+
+    FreeNode* buckets_[BUCKET_COUNT] = {};
+    vector<unique_ptr<char[]>> chunks_;
+    char* chunk_pos_ = nullptr;
+    char* chunk_end_ = nullptr;
+};
+
+// Пул на каждый поток: рабочие потоки пула интерпретаторов строят
+// и разрушают свои деревья независимо, без общих блокировок.
+// Дерево должно освобождаться в том же потоке, где было создано
+Pool& GetPool() {
+    thread_local Pool pool;
+    return pool;
+}
+
+}  // namespace
+
+void* NodePool::Allocate(size_t size) {
+    if (size > MAX_POOLED_SIZE) {
+        return ::operator new(size);
+    }
+
+    return GetPool().Allocate(size);
+}
+
+void NodePool::Deallocate(void* ptr, size_t size) noexcept {
+    if (size > MAX_POOLED_SIZE) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    GetPool().Deallocate(ptr, size);
+}
+
+}  // namespace arena
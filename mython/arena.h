@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+namespace arena {
+
+// Пул памяти для AST-узлов. Деревья программ состоят из тысяч мелких узлов,
+// которые создаются при разборе и разрушаются все разом вместе с программой, -
+// пул раздаёт их из крупных блоков и переиспользует освобождённую память,
+// не обращаясь к куче на каждый узел
+class NodePool {
+public:
+    // Выделяет size байт; блоки больше порога пула идут через operator new
+    static void* Allocate(std::size_t size);
+
+    // Возвращает блок в пул для повторного использования
+    static void Deallocate(void* ptr, std::size_t size) noexcept;
+};
+
+}  // namespace arena
@@ -0,0 +1,248 @@
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Счётчики обращений к куче. Глобальные operator new/delete подменяются
+// только в бенчмарк-бинарнике - основной интерпретатор они не затрагивают
+namespace {
+size_t alloc_count = 0;
+size_t alloc_bytes = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+    ++alloc_count;
+    alloc_bytes += size;
+
+    if (void* ptr = malloc(size)) {
+        return ptr;
+    }
+
+    throw bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept {
+    free(ptr);
+}
+
+namespace {
+
+// Результаты серии запусков одного бенчмарка
+struct Stats {
+    double best_sec = 0;
+    double median_sec = 0;
+    size_t allocs_per_iter = 0;
+    size_t bytes_per_iter = 0;
+};
+
+// Выполняет fn с одним прогревочным запуском и reps измерениями,
+// возвращая лучшее и медианное время одного запуска
+template <typename Fn>
+Stats Measure(int reps, Fn&& fn) {
+    fn();  // прогрев: кэши, таблица символов, пулы
+
+    vector<double> times;
+    times.reserve(reps);
+    Stats stats;
+
+    for (int rep = 0; rep < reps; ++rep) {
+        const size_t allocs_before = alloc_count;
+        const size_t bytes_before = alloc_bytes;
+        const auto start = chrono::steady_clock::now();
+
+        fn();
+
+        const auto finish = chrono::steady_clock::now();
+        times.push_back(chrono::duration<double>(finish - start).count());
+        stats.allocs_per_iter = alloc_count - allocs_before;
+        stats.bytes_per_iter = alloc_bytes - bytes_before;
+    }
+
+    sort(times.begin(), times.end());
+    stats.best_sec = times.front();
+    stats.median_sec = times[times.size() / 2];
+    return stats;
+}
+
+void Report(const string& name, const string& unit, double units_per_iter, const Stats& stats) {
+    cout << left << setw(24) << name << right
+         << setw(12) << fixed << setprecision(0) << units_per_iter / stats.best_sec
+         << ' ' << unit << "/s (best)"
+         << setw(12) << units_per_iter / stats.median_sec << ' ' << unit << "/s (median)"
+         << setw(12) << stats.allocs_per_iter << " allocs"
+         << setw(12) << stats.bytes_per_iter << " bytes"
+         << '\n';
+}
+
+// Каноническая программа: рекурсивное вычисление чисел Фибоначчи
+const string FIB_PROGRAM = R"(
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+f = Fib()
+r = f.calc(18)
+)";
+
+// Каноническая программа: конкатенация строк с удвоением
+const string CONCAT_PROGRAM = R"(
+class Cat:
+  def grow(s, n):
+    if n < 1:
+      return s
+    return self.grow(s + s, n - 1)
+
+c = Cat()
+r = c.grow('mython', 12)
+)";
+
+// Генерирует цепочку наследования глубины depth, метод объявлен в корне
+string MakeDeepHierarchyProgram(int depth) {
+    ostringstream os;
+    os << "class C0:\n  def get():\n    return 1\n\n";
+
+    for (int i = 1; i < depth; ++i) {
+        os << "class C" << i << "(C" << i - 1 << "):\n  def pad" << i << "():\n    return "
+           << i << "\n\n";
+    }
+
+    os << "x = C" << depth - 1 << "()\nr = x.get()";
+
+    for (int i = 0; i < 200; ++i) {
+        os << " + x.get()";
+    }
+
+    os << '\n';
+    return os.str();
+}
+
+// Генерирует класс с field_count полями и методом, суммирующим их все
+string MakeFieldHeavyProgram(int field_count) {
+    ostringstream os;
+    os << "class Rec:\n  def __init__():\n";
+
+    for (int i = 0; i < field_count; ++i) {
+        os << "    self.f" << i << " = " << i << '\n';
+    }
+
+    os << "\n  def total():\n    return self.f0";
+
+    for (int i = 1; i < field_count; ++i) {
+        os << " + self.f" << i;
+    }
+
+    os << "\n\nx = Rec()\nr = x.total()";
+
+    for (int i = 0; i < 50; ++i) {
+        os << " + x.total()";
+    }
+
+    os << '\n';
+    return os.str();
+}
+
+// Генерирует скрипт из line_count простых присваиваний и выражений -
+// нагрузка на лексер и парсер
+string MakeFlatScript(int line_count) {
+    ostringstream os;
+
+    for (int i = 0; i < line_count; ++i) {
+        os << "value_" << i << " = " << i << " + " << i * 2 << " * (" << i << " - 7)\n"
+           << "text_" << i << " = 'str_" << i << "' + \"tail\"\n";
+    }
+
+    return os.str();
+}
+
+// Считает токены до Eof - пропускная способность лексера в буферном режиме
+size_t CountTokens(string_view source) {
+    parse::Lexer lexer(source);
+    size_t count = 1;
+
+    while (!lexer.CurrentToken().Is<parse::token_type::Eof>()) {
+        lexer.NextToken();
+        ++count;
+    }
+
+    return count;
+}
+
+void BenchLexer(int reps) {
+    const string script = MakeFlatScript(2'000);
+    const size_t tokens = CountTokens(script);
+
+    volatile size_t sink = 0;
+    const auto stats = Measure(reps, [&] {
+        sink = CountTokens(script);
+    });
+
+    Report("lexer/flat_script", "tok", static_cast<double>(tokens), stats);
+}
+
+void BenchParser(int reps) {
+    const string script = MakeFlatScript(2'000);
+
+    const auto stats = Measure(reps, [&] {
+        istringstream input(script);
+        parse::Lexer lexer(input);
+        auto program = ParseProgram(lexer);
+    });
+
+    // Две инструкции на строку сценария
+    Report("parse/flat_script", "stmt", 4'000.0, stats);
+}
+
+void BenchExecute(const string& name, const string& script, double units_per_iter, int reps) {
+    istringstream input(script);
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+
+    const auto stats = Measure(reps, [&] {
+        ostringstream output;
+        runtime::SimpleContext context{output};
+        runtime::Closure closure;
+        program->Execute(closure, context);
+    });
+
+    Report(name, "op", units_per_iter, stats);
+}
+
+}  // namespace
+
+int main() {
+    try {
+        const int reps = 5;
+
+        BenchLexer(reps);
+        BenchParser(reps);
+
+        // Для исполнения за единицу работы принят один вызов метода
+        BenchExecute("exec/fib(18)", FIB_PROGRAM, 8'361.0, reps);
+        BenchExecute("exec/string_concat", CONCAT_PROGRAM, 13.0, reps);
+        BenchExecute("exec/deep_hierarchy", MakeDeepHierarchyProgram(20), 201.0, reps);
+        BenchExecute("exec/field_heavy", MakeFieldHeavyProgram(30), 52.0, reps);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
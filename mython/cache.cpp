@@ -0,0 +1,391 @@
+#include "cache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+namespace cache {
+namespace {
+
+// Сигнатура файла кэша («MYTC»)
+constexpr uint32_t MAGIC = 0x4354'594D;
+
+// Теги токенов в файле. Порядок повторяет порядок альтернатив в TokenBase;
+// при его изменении нужно увеличить FORMAT_VERSION
+enum class Tag : uint8_t {
+    Number,
+    Id,
+    Char,
+    String,
+    Class,
+    Return,
+    If,
+    Else,
+    Def,
+    Newline,
+    Print,
+    Indent,
+    Dedent,
+    And,
+    Or,
+    Not,
+    Eq,
+    NotEq,
+    LessOrEq,
+    GreaterOrEq,
+    None,
+    True,
+    False,
+    While,
+    Eof
+};
+
+void WriteU32(ostream& out, uint32_t value) {
+    char bytes[4];
+
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFFU);
+    }
+
+    out.write(bytes, sizeof bytes);
+}
+
+void WriteU64(ostream& out, uint64_t value) {
+    WriteU32(out, static_cast<uint32_t>(value));
+    WriteU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+void WriteString(ostream& out, string_view value) {
+    WriteU32(out, static_cast<uint32_t>(value.size()));
+    out.write(value.data(), static_cast<streamsize>(value.size()));
+}
+
+bool ReadU8(istream& in, uint8_t& value) {
+    char c;
+
+    if (!in.get(c)) {
+        return false;
+    }
+
+    value = static_cast<uint8_t>(c);
+    return true;
+}
+
+bool ReadU32(istream& in, uint32_t& value) {
+    char bytes[4];
+
+    if (!in.read(bytes, sizeof bytes)) {
+        return false;
+    }
+
+    value = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+    }
+
+    return true;
+}
+
+bool ReadU64(istream& in, uint64_t& value) {
+    uint32_t lo, hi;
+
+    if (!ReadU32(in, lo) || !ReadU32(in, hi)) {
+        return false;
+    }
+
+    value = static_cast<uint64_t>(hi) << 32 | lo;
+    return true;
+}
+
+bool ReadString(istream& in, string& value) {
+    uint32_t size;
+
+    if (!ReadU32(in, size)) {
+        return false;
+    }
+
+    // Поле длины не заслуживает доверия: испорченный файл может объявить
+    // гигабайтную строку. Прежде чем выделять память, размер сверяется
+    // с фактическим остатком файла
+    const auto pos = in.tellg();
+    in.seekg(0, ios::end);
+    const auto end = in.tellg();
+    in.seekg(pos);
+
+    if (pos < 0 || end < 0 || static_cast<uint64_t>(end - pos) < size) {
+        return false;
+    }
+
+    value.resize(size);
+    return static_cast<bool>(in.read(value.data(), static_cast<streamsize>(size)));
+}
+
+}  // namespace
+
+uint64_t HashSource(string_view source) {
+    // FNV-1a
+    uint64_t hash = 0xCBF2'9CE4'8422'2325ULL;
+
+    for (const char c : source) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x0000'0100'0000'01B3ULL;
+    }
+
+    return hash;
+}
+
+vector<parse::Token> RecordTokens(parse::Lexer& lexer) {
+    vector<parse::Token> result;
+
+    while (!lexer.CurrentToken().Is<parse::token_type::Eof>()) {
+        result.push_back(lexer.CurrentToken());
+        lexer.NextToken();
+    }
+
+    return result;
+}
+
+void SaveTokens(ostream& out, const vector<parse::Token>& tokens) {
+    using namespace parse;
+
+    // Таблица имён: каждое уникальное имя записывается один раз,
+    // токены Id ссылаются на него по номеру
+    vector<string_view> names;
+    unordered_map<string_view, uint32_t> name_index;
+
+    for (const Token& token : tokens) {
+        if (const auto* id = token.TryAs<token_type::Id>()) {
+            if (name_index.emplace(id->value, static_cast<uint32_t>(names.size())).second) {
+                names.push_back(id->value);
+            }
+        }
+    }
+
+    WriteU32(out, MAGIC);
+    WriteU32(out, FORMAT_VERSION);
+    WriteU32(out, static_cast<uint32_t>(names.size()));
+
+    for (const string_view name : names) {
+        WriteString(out, name);
+    }
+
+    WriteU64(out, tokens.size());
+
+    for (const Token& token : tokens) {
+        // Порядок альтернатив TokenBase совпадает с порядком тегов
+        out.put(static_cast<char>(token.index()));
+
+        if (const auto* number = token.TryAs<token_type::Number>()) {
+            WriteU32(out, static_cast<uint32_t>(number->value));
+        } else if (const auto* id = token.TryAs<token_type::Id>()) {
+            WriteU32(out, name_index.at(id->value));
+        } else if (const auto* symbol = token.TryAs<token_type::Char>()) {
+            out.put(symbol->value);
+        } else if (const auto* str = token.TryAs<token_type::String>()) {
+            WriteString(out, str->value);
+        }
+    }
+}
+
+optional<vector<parse::Token>> LoadTokens(istream& in) {
+    using namespace parse;
+
+    uint32_t magic, version, name_count;
+
+    if (!ReadU32(in, magic) || magic != MAGIC || !ReadU32(in, version)
+        || version != FORMAT_VERSION || !ReadU32(in, name_count)) {
+        return nullopt;
+    }
+
+    // Имена интернируются при загрузке: токены Id сразу несут готовые символы
+    vector<pair<string, runtime::Symbol>> names(name_count);
+
+    for (auto& [name, symbol] : names) {
+        if (!ReadString(in, name)) {
+            return nullopt;
+        }
+
+        symbol = runtime::Symbol(name);
+    }
+
+    uint64_t token_count;
+
+    if (!ReadU64(in, token_count)) {
+        return nullopt;
+    }
+
+    vector<Token> result;
+    result.reserve(token_count);
+
+    for (uint64_t i = 0; i < token_count; ++i) {
+        uint8_t tag;
+
+        if (!ReadU8(in, tag)) {
+            return nullopt;
+        }
+
+        switch (static_cast<Tag>(tag)) {
+            case Tag::Number: {
+                uint32_t value;
+
+                if (!ReadU32(in, value)) {
+                    return nullopt;
+                }
+
+                result.emplace_back(token_type::Number{static_cast<int>(value)});
+                break;
+            }
+            case Tag::Id: {
+                uint32_t index;
+
+                if (!ReadU32(in, index) || index >= names.size()) {
+                    return nullopt;
+                }
+
+                result.emplace_back(token_type::Id{names[index].first, names[index].second});
+                break;
+            }
+            case Tag::Char: {
+                uint8_t value;
+
+                if (!ReadU8(in, value)) {
+                    return nullopt;
+                }
+
+                result.emplace_back(token_type::Char{static_cast<char>(value)});
+                break;
+            }
+            case Tag::String: {
+                string value;
+
+                if (!ReadString(in, value)) {
+                    return nullopt;
+                }
+
+                result.emplace_back(token_type::String{move(value)});
+                break;
+            }
+            case Tag::Class:
+                result.emplace_back(token_type::Class{});
+                break;
+            case Tag::Return:
+                result.emplace_back(token_type::Return{});
+                break;
+            case Tag::If:
+                result.emplace_back(token_type::If{});
+                break;
+            case Tag::Else:
+                result.emplace_back(token_type::Else{});
+                break;
+            case Tag::Def:
+                result.emplace_back(token_type::Def{});
+                break;
+            case Tag::Newline:
+                result.emplace_back(token_type::Newline{});
+                break;
+            case Tag::Print:
+                result.emplace_back(token_type::Print{});
+                break;
+            case Tag::Indent:
+                result.emplace_back(token_type::Indent{});
+                break;
+            case Tag::Dedent:
+                result.emplace_back(token_type::Dedent{});
+                break;
+            case Tag::And:
+                result.emplace_back(token_type::And{});
+                break;
+            case Tag::Or:
+                result.emplace_back(token_type::Or{});
+                break;
+            case Tag::Not:
+                result.emplace_back(token_type::Not{});
+                break;
+            case Tag::Eq:
+                result.emplace_back(token_type::Eq{});
+                break;
+            case Tag::NotEq:
+                result.emplace_back(token_type::NotEq{});
+                break;
+            case Tag::LessOrEq:
+                result.emplace_back(token_type::LessOrEq{});
+                break;
+            case Tag::GreaterOrEq:
+                result.emplace_back(token_type::GreaterOrEq{});
+                break;
+            case Tag::None:
+                result.emplace_back(token_type::None{});
+                break;
+            case Tag::True:
+                result.emplace_back(token_type::True{});
+                break;
+            case Tag::False:
+                result.emplace_back(token_type::False{});
+                break;
+            case Tag::While:
+                result.emplace_back(token_type::While{});
+                break;
+            case Tag::Eof:
+                result.emplace_back(token_type::Eof{});
+                break;
+            default:
+                return nullopt;
+        }
+    }
+
+    return result;
+}
+
+string CacheFilePath(uint64_t hash) {
+    namespace fs = std::filesystem;
+
+    const char* env_dir = getenv("MYTHON_CACHE_DIR");
+    const fs::path dir = env_dir != nullptr ? fs::path(env_dir)
+                                            : fs::temp_directory_path() / "mython-cache";
+
+    error_code ec;
+    fs::create_directories(dir, ec);
+
+    char name[sizeof hash * 2 + sizeof ".tokc"];
+    snprintf(name, sizeof name, "%016llx.tokc", static_cast<unsigned long long>(hash));
+
+    return (dir / name).string();
+}
+
+optional<vector<parse::Token>> LoadCachedTokens(string_view source) {
+    ifstream in(CacheFilePath(HashSource(source)), ios::binary);
+
+    if (!in) {
+        return nullopt;
+    }
+
+    return LoadTokens(in);
+}
+
+void StoreCachedTokens(string_view source, const vector<parse::Token>& tokens) {
+    const string path = CacheFilePath(HashSource(source));
+    ofstream out(path, ios::binary | ios::trunc);
+
+    if (!out) {
+        return;
+    }
+
+    SaveTokens(out, tokens);
+
+    if (!out) {
+        // Недописанный файл вводил бы в заблуждение - лучше без кэша
+        out.close();
+        error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+}
+
+}  // namespace cache
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "lexer.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cache {
+
+/*
+ * Дисковый кэш скомпилированных программ. Результат лексического разбора
+ * (поток токенов вместе с таблицей интернированных имён) сохраняется
+ * в двоичном файле, ключом служит хеш исходного текста. При повторном
+ * запуске того же скрипта токены загружаются одним чтением, минуя
+ * посимвольный разбор, а имена сразу получают номера в таблице символов.
+ *
+ * Формат версионирован: файл с другой версией или повреждённым
+ * содержимым молча игнорируется и перезаписывается
+ */
+
+// Версия двоичного формата. Увеличивается при любом несовместимом
+// изменении кодировки токенов
+constexpr std::uint32_t FORMAT_VERSION = 2;
+
+// 64-битный FNV-1a хеш исходного текста - ключ кэша
+std::uint64_t HashSource(std::string_view source);
+
+// Прогоняет лексер до Eof и возвращает все прочитанные токены
+// (без завершающего Eof - при воспроизведении он подставляется сам)
+std::vector<parse::Token> RecordTokens(parse::Lexer& lexer);
+
+// Записывает токены в поток в двоичном формате вместе с таблицей имён
+void SaveTokens(std::ostream& out, const std::vector<parse::Token>& tokens);
+
+// Читает токены из потока. Возвращает std::nullopt, если формат
+// не распознан, версия не совпала или данные повреждены
+std::optional<std::vector<parse::Token>> LoadTokens(std::istream& in);
+
+// Путь к файлу кэша для данного хеша: каталог из переменной окружения
+// MYTHON_CACHE_DIR либо подкаталог mython-cache во временном каталоге
+std::string CacheFilePath(std::uint64_t hash);
+
+// Ищет в кэше токены для данного исходного текста
+std::optional<std::vector<parse::Token>> LoadCachedTokens(std::string_view source);
+
+// Сохраняет токены в кэш. Ошибки записи игнорируются:
+// кэш - ускорение, а не обязательное условие работы
+void StoreCachedTokens(std::string_view source, const std::vector<parse::Token>& tokens);
+
+}  // namespace cache
@@ -0,0 +1,116 @@
+#include "cache.h"
+#include "parse.h"
+#include "runtime.h"
+#include "test_runner_p.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace cache {
+namespace {
+
+void TestTokensRoundTrip() {
+    using namespace parse;
+
+    istringstream input(R"(
+class Greeting:
+  def hello(name):
+    return 'Hello, ' + name
+
+g = Greeting()
+print g.hello('world'), 4 * 2
+)");
+
+    Lexer lexer(input);
+    const auto tokens = RecordTokens(lexer);
+
+    stringstream file(ios::in | ios::out | ios::binary);
+    SaveTokens(file, tokens);
+
+    const auto loaded = LoadTokens(file);
+    ASSERT(loaded.has_value());
+    ASSERT_EQUAL(loaded->size(), tokens.size());
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        ASSERT_EQUAL((*loaded)[i], tokens[i]);
+    }
+
+    // Загруженные идентификаторы несут интернированные имена
+    for (const Token& token : *loaded) {
+        if (const auto* id = token.TryAs<token_type::Id>()) {
+            ASSERT_EQUAL(id->symbol.GetName(), id->value);
+        }
+    }
+}
+
+void TestRecordedReplayAndRewind() {
+    using namespace parse;
+
+    istringstream input(R"(
+x = 2
+print x * 21
+)");
+
+    Lexer lexer(input);
+    const auto tokens = RecordTokens(lexer);
+
+    // Курсор читает запись без копирования, а Rewind возвращает его
+    // к началу - повторный разбор стоит только времени парсера
+    Lexer cursor(tokens);
+
+    for (int i = 0; i < 2; ++i) {
+        ostringstream output;
+        runtime::SimpleContext context(output);
+        runtime::Closure closure;
+
+        ParseProgram(cursor)->Execute(closure, context);
+
+        ASSERT_EQUAL(output.str(), "42\n"s);
+        cursor.Rewind();
+    }
+
+    // Несколько курсоров могут одновременно читать одну запись
+    Lexer other(tokens);
+    ASSERT_EQUAL(other.CurrentToken(), tokens.front());
+
+    // Вне режима воспроизведения перемотки нет
+    istringstream stream_input("x = 1"s);
+    Lexer stream_lexer(stream_input);
+    ASSERT_THROWS(stream_lexer.Rewind(), LexerError);
+}
+
+void TestCorruptedFileIsRejected() {
+    istringstream garbage("definitely not a cache file"s, ios::binary);
+    ASSERT(!LoadTokens(garbage).has_value());
+}
+
+void TestOversizedLengthIsRejected() {
+    using namespace parse;
+
+    istringstream input("abc = 1"s);
+    Lexer lexer(input);
+
+    stringstream file(ios::in | ios::out | ios::binary);
+    SaveTokens(file, RecordTokens(lexer));
+
+    // Портится поле длины первого имени (байты 12..15, за сигнатурой,
+    // версией и числом имён): длина больше остатка файла должна
+    // отвергаться до выделения памяти под строку
+    string data = file.str();
+    data[12] = data[13] = data[14] = data[15] = static_cast<char>(0xFF);
+
+    istringstream corrupted(data, ios::binary);
+    ASSERT(!LoadTokens(corrupted).has_value());
+}
+
+}  // namespace
+
+void RunCacheTests(TestRunner& tr) {
+    RUN_TEST(tr, TestTokensRoundTrip);
+    RUN_TEST(tr, TestRecordedReplayAndRewind);
+    RUN_TEST(tr, TestCorruptedFileIsRejected);
+    RUN_TEST(tr, TestOversizedLengthIsRejected);
+}
+
+}  // namespace cache
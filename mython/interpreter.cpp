@@ -0,0 +1,100 @@
+#include "interpreter.h"
+
+#include "cache.h"
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+void RunMythonProgram(istream& input, ostream& output) {
+    parse::Lexer lexer(input);
+
+    runtime::SimpleContext context{output};
+
+    {
+        // Потоковый режим: инструкции исполняются по мере разбора, первый
+        // вывод появляется раньше, чем дочитан ввод, а память не держит
+        // дерево всей программы
+        runtime::Closure closure;
+        ParseAndExecuteProgram(lexer, closure, context);
+    }
+
+    // Замыкания больше нет: всё, что осталось в реестре экземпляров,
+    // удерживается только циклами ссылок
+    runtime::CollectCycles(runtime::Closure{});
+}
+
+void RunMythonFile(const char* path, ostream& output) {
+    const int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        throw runtime_error("Cannot open file "s + path);
+    }
+
+    struct stat st{};
+
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw runtime_error("Cannot stat file "s + path);
+    }
+
+    const auto size = static_cast<size_t>(st.st_size);
+    void* data = nullptr;
+
+    if (size > 0) {
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Cannot mmap file "s + path);
+        }
+    }
+
+    close(fd);
+
+    try {
+        const auto source = data ? string_view(static_cast<const char*>(data), size)
+                                 : string_view{};
+
+        // Кэш разбора: для уже встречавшегося текста токены загружаются
+        // с диска одним чтением, иначе файл лексируется и кэш пополняется
+        auto tokens = cache::LoadCachedTokens(source);
+
+        if (!tokens) {
+            parse::Lexer scanner(source);
+            tokens = cache::RecordTokens(scanner);
+            cache::StoreCachedTokens(source, *tokens);
+        }
+
+        parse::Lexer lexer(std::move(*tokens));
+
+        runtime::SimpleContext context{output};
+
+        {
+            runtime::Closure closure;
+            ParseAndExecuteProgram(lexer, closure, context);
+        }
+
+        runtime::CollectCycles(runtime::Closure{});
+    } catch (...) {
+        if (data) {
+            munmap(data, size);
+        }
+        throw;
+    }
+
+    if (data) {
+        munmap(data, size);
+    }
+}
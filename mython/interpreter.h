@@ -0,0 +1,12 @@
+#pragma once
+
+#include <iosfwd>
+
+// Читает программу из input, исполняет её и пишет вывод в output.
+// Инструкции верхнего уровня исполняются по мере разбора (см. parse.h)
+void RunMythonProgram(std::istream& input, std::ostream& output);
+
+// Выполняет скрипт из файла path, отображённого в память: лексер сканирует
+// файл как сплошной буфер, а для уже встречавшегося текста токены
+// загружаются из дискового кэша (см. cache.h)
+void RunMythonFile(const char* path, std::ostream& output);
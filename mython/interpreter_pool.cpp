@@ -0,0 +1,139 @@
+#include "interpreter_pool.h"
+
+#include "cache.h"
+#include "parse.h"
+#include "runtime.h"
+
+#include <sstream>
+#include <utility>
+
+using namespace std;
+
+namespace pool {
+
+SharedProgram::SharedProgram(istream& source) {
+    parse::Lexer lexer(source);
+    tokens_ = cache::RecordTokens(lexer);
+}
+
+SharedProgram::SharedProgram(string_view source) {
+    parse::Lexer lexer(source);
+    tokens_ = cache::RecordTokens(lexer);
+}
+
+InterpreterPool::InterpreterPool(size_t worker_count,
+                                 shared_ptr<const SharedProgram> prelude) :
+    prelude_(move(prelude)) {
+    workers_.reserve(worker_count);
+
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this] {
+            WorkerLoop();
+        });
+    }
+}
+
+InterpreterPool::~InterpreterPool() {
+    {
+        lock_guard lock(mutex_);
+        stopped_ = true;
+    }
+
+    ready_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+future<string> InterpreterPool::Submit(shared_ptr<const SharedProgram> program) {
+    Job job{move(program), {}};
+    auto result = job.result.get_future();
+
+    {
+        lock_guard lock(mutex_);
+        jobs_.push_back(move(job));
+    }
+
+    ready_.notify_one();
+    return result;
+}
+
+void InterpreterPool::WorkerLoop() {
+    // Прелюдия инстанцируется один раз на поток: её дерево строится
+    // и живёт в этом потоке (этого требует потоковый пул узлов),
+    // а объекты Class исполняют тела методов по указателям в него
+    unique_ptr<runtime::Executable> prelude_tree;
+    runtime::Closure prelude_closure;
+    exception_ptr prelude_error;
+
+    if (prelude_) {
+        try {
+            ostringstream sink;
+            runtime::SimpleContext context{sink};
+
+            parse::Lexer lexer(prelude_->GetTokens());
+            prelude_tree = ParseProgram(lexer);
+            prelude_tree->Execute(prelude_closure, context);
+        } catch (...) {
+            prelude_error = current_exception();
+        }
+    }
+
+    for (;;) {
+        Job job;
+
+        {
+            unique_lock lock(mutex_);
+            ready_.wait(lock, [this] {
+                return stopped_ || !jobs_.empty();
+            });
+
+            if (jobs_.empty()) {
+                // stopped_ выставлен, очередь дочитана
+                return;
+            }
+
+            job = move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        if (prelude_error) {
+            // Ошибка прелюдии фатальна для всех заданий потока
+            job.result.set_exception(prelude_error);
+            continue;
+        }
+
+        RunJob(job, prelude_closure);
+    }
+}
+
+void InterpreterPool::RunJob(Job& job, const runtime::Closure& prelude_closure) {
+    try {
+        // Дерево программы строится, исполняется и разрушается внутри
+        // одного рабочего потока - этого требует потоковый пул узлов
+        parse::Lexer lexer(job.program->GetTokens());
+        auto program = ParseProgram(lexer, prelude_closure);
+
+        ostringstream output;
+        runtime::SimpleContext context{output};
+
+        {
+            // Свежее замыкание засевается именами прелюдии; копия
+            // разделяет сами объекты по счётчику ссылок
+            runtime::Closure closure = prelude_closure;
+            program->Execute(closure, context);
+        }
+
+        // Циклические графы объектов пережили бы задание - реестр
+        // экземпляров потока очищается от недостижимых циклов; корни
+        // прелюдии при этом остаются живыми
+        runtime::CollectCycles(prelude_closure);
+
+        job.result.set_value(output.str());
+    } catch (...) {
+        job.result.set_exception(current_exception());
+    }
+}
+
+}  // namespace pool
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "lexer.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+class Closure;
+}
+
+namespace pool {
+
+/*
+ * Встраиваемый API для параллельного исполнения независимых Mython-программ.
+ *
+ * SharedProgram - однократно разобранный исходный текст в виде записанного
+ * потока токенов. После конструирования токены не меняются, поэтому один
+ * экземпляр можно одновременно отдавать многим рабочим потокам. Дерево
+ * программы каждый поток строит себе сам: узлы AST несут изменяемые
+ * встроенные кэши методов и полей, а пул узлов у каждого потока свой,
+ * так что готовые деревья между потоками не разделяются.
+ *
+ * Каждое задание исполняется с собственными Closure и Context, поэтому
+ * графы объектов не пересекают границы потоков и счётчики ссылок
+ * остаются неатомарными.
+ *
+ * Пул может быть создан с прелюдией - общей программой-библиотекой,
+ * которую каждый поток разбирает и исполняет один раз при старте. Задания
+ * получают копию замыкания прелюдии, так что её классы и константы видны
+ * скриптам без повторного разбора. Экземпляры классов, созданные
+ * прелюдией, разделяются всеми заданиями потока по ссылке - прелюдия
+ * должна определять классы, а не изменяемое состояние
+ */
+
+// Программа, пригодная для совместного использования рабочими потоками
+class SharedProgram {
+public:
+    explicit SharedProgram(std::istream& source);
+    explicit SharedProgram(std::string_view source);
+
+    [[nodiscard]] const std::vector<parse::Token>& GetTokens() const {
+        return tokens_;
+    }
+
+private:
+    std::vector<parse::Token> tokens_;
+};
+
+// Пул рабочих потоков, исполняющих поставленные в очередь программы
+class InterpreterPool {
+public:
+    explicit InterpreterPool(std::size_t worker_count,
+                             std::shared_ptr<const SharedProgram> prelude = nullptr);
+
+    InterpreterPool(const InterpreterPool&) = delete;
+    InterpreterPool& operator=(const InterpreterPool&) = delete;
+
+    // Дожидается завершения уже поставленных заданий и останавливает потоки
+    ~InterpreterPool();
+
+    // Ставит программу в очередь на исполнение. Будущее получает вывод
+    // программы либо исключение, выброшенное при разборе или исполнении
+    std::future<std::string> Submit(std::shared_ptr<const SharedProgram> program);
+
+private:
+    struct Job {
+        std::shared_ptr<const SharedProgram> program;
+        std::promise<std::string> result;
+    };
+
+    void WorkerLoop();
+    static void RunJob(Job& job, const runtime::Closure& prelude_closure);
+
+    std::shared_ptr<const SharedProgram> prelude_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Job> jobs_;
+    bool stopped_ = false;
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace pool
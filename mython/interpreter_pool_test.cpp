@@ -0,0 +1,114 @@
+#include "interpreter_pool.h"
+#include "test_runner_p.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace pool {
+namespace {
+
+void TestConcurrentExecution() {
+    InterpreterPool interpreters(4);
+
+    // Одна и та же программа разделяется всеми заданиями,
+    // остальные у каждого задания свои
+    const auto shared = make_shared<const SharedProgram>(R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add():
+    self.value = self.value + 1
+
+c = Counter()
+c.add()
+c.add()
+print c.value
+)"sv);
+
+    vector<future<string>> results;
+    vector<string> expected;
+
+    for (int i = 0; i < 32; ++i) {
+        if (i % 2 == 0) {
+            results.push_back(interpreters.Submit(shared));
+            expected.push_back("2\n"s);
+        } else {
+            const string source = "x = "s + to_string(i) + "\nprint x * x\n"s;
+            results.push_back(interpreters.Submit(make_shared<const SharedProgram>(source)));
+            expected.push_back(to_string(i * i) + "\n"s);
+        }
+    }
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        ASSERT_EQUAL(results[i].get(), expected[i]);
+    }
+}
+
+void TestExceptionReachesCaller() {
+    InterpreterPool interpreters(1);
+    auto result = interpreters.Submit(make_shared<const SharedProgram>("print y\n"sv));
+
+    try {
+        result.get();
+        ASSERT(false);
+    } catch (const runtime_error&) {
+        // Ожидаемо: имя y не определено
+    }
+}
+
+void TestPreludeSharedAcrossJobs() {
+    // Классы прелюдии видны всем заданиям без повторного разбора,
+    // а состояние самих скриптов не пересекается
+    const auto prelude = make_shared<const SharedProgram>(R"(
+class Adder:
+  def __init__(base):
+    self.base = base
+
+  def add(value):
+    return self.base + value
+)"sv);
+
+    InterpreterPool interpreters(2, prelude);
+
+    vector<future<string>> results;
+    vector<string> expected;
+
+    for (int i = 0; i < 16; ++i) {
+        const string source = "a = Adder("s + to_string(i) + ")\nprint a.add(10)\n"s;
+        results.push_back(interpreters.Submit(make_shared<const SharedProgram>(source)));
+        expected.push_back(to_string(i + 10) + "\n"s);
+    }
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        ASSERT_EQUAL(results[i].get(), expected[i]);
+    }
+}
+
+void TestBrokenPreludeFailsJobs() {
+    const auto prelude = make_shared<const SharedProgram>("print missing\n"sv);
+    InterpreterPool interpreters(1, prelude);
+
+    auto result = interpreters.Submit(make_shared<const SharedProgram>("print 1\n"sv));
+
+    try {
+        result.get();
+        ASSERT(false);
+    } catch (const runtime_error&) {
+        // Ожидаемо: ошибка прелюдии фатальна для заданий
+    }
+}
+
+}  // namespace
+
+void RunInterpreterPoolTests(TestRunner& tr) {
+    RUN_TEST(tr, TestConcurrentExecution);
+    RUN_TEST(tr, TestExceptionReachesCaller);
+    RUN_TEST(tr, TestPreludeSharedAcrossJobs);
+    RUN_TEST(tr, TestBrokenPreludeFailsJobs);
+}
+
+}  // namespace pool
@@ -1,7 +1,7 @@
 #include "lexer.h"
 
 #include <algorithm>
-#include <cctype>
+#include <array>
 #include <charconv>
 #include <cstddef>
 #include <istream>
@@ -17,8 +17,60 @@ namespace parse {
 
 namespace details {
 
+namespace {
+
+// Классы символов сканера. Таблица на все 256 значений байта заменяет
+// локалезависимые isalpha/isdigit и цепочки сравнений одним чтением
+enum CharClass : unsigned char {
+    CHAR_DIGIT = 1,
+    CHAR_IDENT_START = 2,  // буква или '_'
+    CHAR_COMPARE = 4,      // первый символ оператора сравнения
+};
+
+constexpr auto CHAR_CLASSES = [] {
+    array<unsigned char, 256> table{};
+
+    for (int c = '0'; c <= '9'; ++c) {
+        table[c] |= CHAR_DIGIT;
+    }
+
+    for (int c = 'a'; c <= 'z'; ++c) {
+        table[c] |= CHAR_IDENT_START;
+    }
+
+    for (int c = 'A'; c <= 'Z'; ++c) {
+        table[c] |= CHAR_IDENT_START;
+    }
+
+    table['_'] |= CHAR_IDENT_START;
+
+    for (const char c : {'=', '!', '<', '>'}) {
+        table[static_cast<unsigned char>(c)] |= CHAR_COMPARE;
+    }
+
+    return table;
+}();
+
+constexpr unsigned char ClassOf(char c) {
+    return CHAR_CLASSES[static_cast<unsigned char>(c)];
+}
+
+}  // namespace
+
+bool IsDigit(char c) {
+    return (ClassOf(c) & CHAR_DIGIT) != 0;
+}
+
+bool IsIdentStart(char c) {
+    return (ClassOf(c) & CHAR_IDENT_START) != 0;
+}
+
+bool IsIdentChar(char c) {
+    return (ClassOf(c) & (CHAR_DIGIT | CHAR_IDENT_START)) != 0;
+}
+
 bool IsSpecialChar(char c) {
-    return c == '=' || c == '!' || c == '<' || c == '>';
+    return (ClassOf(c) & CHAR_COMPARE) != 0;
 }
 
 string ReadLine(istream& input) {
@@ -47,34 +99,104 @@ Token ReadCompareOperator(char c) {
     }
 }
 
-Token ReadKeyword(string literal) {
-    if (literal == "class"s) {
-        return token_type::Class{};
-    } else if (literal == "return"s) {
-        return token_type::Return{};
-    } else if (literal == "if"s) {
-        return token_type::If{};
-    } else if (literal == "else"s) {
-        return token_type::Else{};
-    } else if (literal == "def"s) {
-        return token_type::Def{};
-    } else if (literal == "print"s) {
-        return token_type::Print{};
-    } else if (literal == "or"s) {
-        return token_type::Or{};
-    } else if (literal == "None"s) {
-        return token_type::None{};
-    } else if (literal == "and"s) {
-        return token_type::And{};
-    } else if (literal == "not"s) {
-        return token_type::Not{};
-    } else if (literal == "True"s) {
-        return token_type::True{};
-    } else if (literal == "False"s) {
-        return token_type::False{};
-    }
-
-    return token_type::Id{move(literal)};
+Token ReadKeyword(string_view literal) {
+    // Ключевые слова распознаются за две ветви - по длине и первому
+    // символу; кандидат остаётся один, и хватает единственного сравнения
+    // вместо перебора всего списка для каждого идентификатора
+    switch (literal.size()) {
+        case 2:
+            if (literal == "if"sv) {
+                return token_type::If{};
+            }
+            if (literal == "or"sv) {
+                return token_type::Or{};
+            }
+            break;
+
+        case 3:
+            switch (literal.front()) {
+                case 'a':
+                    if (literal == "and"sv) {
+                        return token_type::And{};
+                    }
+                    break;
+                case 'd':
+                    if (literal == "def"sv) {
+                        return token_type::Def{};
+                    }
+                    break;
+                case 'n':
+                    if (literal == "not"sv) {
+                        return token_type::Not{};
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+
+        case 4:
+            switch (literal.front()) {
+                case 'e':
+                    if (literal == "else"sv) {
+                        return token_type::Else{};
+                    }
+                    break;
+                case 'N':
+                    if (literal == "None"sv) {
+                        return token_type::None{};
+                    }
+                    break;
+                case 'T':
+                    if (literal == "True"sv) {
+                        return token_type::True{};
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+
+        case 5:
+            switch (literal.front()) {
+                case 'c':
+                    if (literal == "class"sv) {
+                        return token_type::Class{};
+                    }
+                    break;
+                case 'p':
+                    if (literal == "print"sv) {
+                        return token_type::Print{};
+                    }
+                    break;
+                case 'F':
+                    if (literal == "False"sv) {
+                        return token_type::False{};
+                    }
+                    break;
+                case 'w':
+                    if (literal == "while"sv) {
+                        return token_type::While{};
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+
+        case 6:
+            if (literal == "return"sv) {
+                return token_type::Return{};
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    // Идентификатор интернируется уже на этапе лексического анализа:
+    // дальше по конвейеру имя живёт как целочисленный символ
+    return token_type::Id{string(literal), runtime::Symbol(literal)};
 }
 
 string ReadLiteral(istream& input) {
@@ -82,7 +204,7 @@ string ReadLiteral(istream& input) {
     char c;
 
     while(input.get(c)) {
-        if (isdigit(c) || isalpha(c) || c == '_') {
+        if (IsIdentChar(c)) {
             literal.push_back(c);
         } else {
             input.putback(c);
@@ -93,15 +215,63 @@ string ReadLiteral(istream& input) {
     return literal;
 }
 
-token_type::Number ReadNumber(istream& input) {
-    int number;
-    input >> number;
+// Холодный путь разбора числа: литерал не помещается в int
+[[noreturn]] void ThrowNumberOutOfRange(string_view literal, string_view line) {
+    stringstream s;
 
-    return {number};
+    s << "number literal "sv << literal << " does not fit into int in line: "sv << line;
+
+    throw LexerError(s.str());
 }
 
-token_type::Id ReadId(istream& input) {
-    return {ReadLiteral(input)};
+token_type::Number ReadNumber(istringstream& input) {
+    // Цифры собираются в буфер на стеке и конвертируются from_chars:
+    // operator>> с его sentry, фасетами локали и виртуальными вызовами
+    // streambuf на горячем пути литералов не нужен. Шестнадцати символов
+    // хватает любому значащему литералу в диапазоне int
+    array<char, 16> digits;
+    size_t count = 0;
+    size_t zeros = 0;
+    string overflow;
+    char c;
+
+    // Ведущие нули значения не несут и в буфер не попадают -
+    // учитывается лишь их число для диагностики
+    while (input.get(c)) {
+        if (c != '0') {
+            input.putback(c);
+            break;
+        }
+
+        ++zeros;
+    }
+
+    while (input.get(c)) {
+        if (!IsDigit(c)) {
+            input.putback(c);
+            break;
+        }
+
+        if (count < digits.size()) {
+            digits[count++] = c;
+        } else {
+            // Более 16 значащих цифр - заведомое переполнение; хвост
+            // дочитывается только ради полного литерала в диагностике
+            overflow.push_back(c);
+        }
+    }
+
+    int number = 0;
+    const auto result = from_chars(digits.data(), digits.data() + count, number);
+
+    if (!overflow.empty() || result.ec == errc::result_out_of_range) {
+        string literal(zeros, '0');
+        literal.append(digits.data(), count);
+        literal += overflow;
+        ThrowNumberOutOfRange(literal, input.str());
+    }
+
+    return {number};
 }
 
 token_type::String ReadString(istream& input, char prefix) {
@@ -204,6 +374,7 @@ std::ostream& operator<<(std::ostream& os, const Token& rhs) {
     UNVALUED_OUTPUT(None);
     UNVALUED_OUTPUT(True);
     UNVALUED_OUTPUT(False);
+    UNVALUED_OUTPUT(While);
     UNVALUED_OUTPUT(Eof);
 
 #undef UNVALUED_OUTPUT
@@ -212,8 +383,36 @@ std::ostream& operator<<(std::ostream& os, const Token& rhs) {
 }
 
 Lexer::Lexer(std::istream& input) :
-    input_(input) {
-    line_ = ReadNextLine(input_, context_);
+    input_(&input) {
+    line_ = ReadNextLine(*input_, context_);
+    NextToken();
+}
+
+Lexer::Lexer(std::string_view source) :
+    source_(source) {
+    ReadNextLineView();
+    NextToken();
+}
+
+Lexer::Lexer(std::vector<Token>&& tokens) :
+    recorded_(std::move(tokens)),
+    replay_source_(&recorded_),
+    replay_(true) {
+    NextToken();
+}
+
+Lexer::Lexer(const std::vector<Token>& tokens) :
+    replay_source_(&tokens),
+    replay_(true) {
+    NextToken();
+}
+
+void Lexer::Rewind() {
+    if (!replay_) {
+        throw LexerError("Rewind is only available for a recorded token stream"s);
+    }
+
+    replay_pos_ = 0;
     NextToken();
 }
 
@@ -221,11 +420,28 @@ const Token& Lexer::CurrentToken() const {
     return current_token_;
 }
 
+void Lexer::ThrowExpectError(const char* type_name) {
+    std::stringstream s;
+
+    s << type_name << " is expected"sv;
+
+    throw LexerError(s.str());
+}
+
 Token Lexer::NextToken() {
     return current_token_ = ReadToken();
 }
 
 Token Lexer::ReadToken() {
+    if (replay_) {
+        return replay_pos_ < replay_source_->size() ? (*replay_source_)[replay_pos_++]
+                                                    : Token(token_type::Eof{});
+    }
+
+    return input_ ? ReadStreamToken() : ReadBufferToken();
+}
+
+Token Lexer::ReadStreamToken() {
     if (context_.new_indent > context_.indent) {
         ++context_.indent;
         return token_type::Indent{};
@@ -237,7 +453,7 @@ Token Lexer::ReadToken() {
     char c;
 
     if (!line_.get(c)) {
-        if (input_.eof()) {
+        if (input_->eof()) {
             if (context_.indent > 0) {
                 --context_.indent;
                 context_.new_indent = 0;
@@ -247,8 +463,8 @@ Token Lexer::ReadToken() {
             return token_type::Eof{};
         }
 
-        line_ = ReadNextLine(input_, context_);
-        return ReadToken();
+        line_ = ReadNextLine(*input_, context_);
+        return ReadStreamToken();
     }
 
     if (c == '\n') {
@@ -271,7 +487,7 @@ Token Lexer::ReadToken() {
         }
     }
 
-    if (isalpha(c) || c == '_') {
+    if (details::IsIdentStart(c)) {
         line_.putback(c);
         return details::ReadKeyword(details::ReadLiteral(line_));
     }
@@ -280,7 +496,7 @@ Token Lexer::ReadToken() {
         return details::ReadString(line_, c);
     }
 
-    if (isdigit(c)) {
+    if (details::IsDigit(c)) {
         line_.putback(c);
         return details::ReadNumber(line_);
     }
@@ -306,4 +522,199 @@ istringstream Lexer::ReadNextLine(std::istream& input, Context& context) {
     return istringstream();
 }
 
+Token Lexer::ReadBufferToken() {
+    if (context_.new_indent > context_.indent) {
+        ++context_.indent;
+        return token_type::Indent{};
+    } else if (context_.new_indent < context_.indent) {
+        --context_.indent;
+        return token_type::Dedent{};
+    }
+
+    // Выдаёт следующий символ строки; конец строки читается как '\n',
+    // после чего строка считается исчерпанной
+    auto get = [this]() -> int {
+        if (line_pos_ < line_view_.size()) {
+            return static_cast<unsigned char>(line_view_[line_pos_++]);
+        }
+
+        if (line_pos_ == line_view_.size()) {
+            ++line_pos_;
+            return '\n';
+        }
+
+        return -1;
+    };
+
+    const int next = get();
+
+    if (next < 0) {
+        if (pos_ >= source_.size()) {
+            if (context_.indent > 0) {
+                --context_.indent;
+                context_.new_indent = 0;
+                return token_type::Dedent{};
+            }
+
+            return token_type::Eof{};
+        }
+
+        ReadNextLineView();
+        return ReadBufferToken();
+    }
+
+    char c = static_cast<char>(next);
+
+    if (c == '\n') {
+        return token_type::Newline{};
+    }
+
+    while (c == ' ') {
+        c = static_cast<char>(get());
+    }
+
+    if (c == '#') {
+        line_pos_ = line_view_.size() + 1;
+        return token_type::Newline{};
+    }
+
+    if (details::IsSpecialChar(c)) {
+        if (line_pos_ < line_view_.size() && line_view_[line_pos_] == '=') {
+            ++line_pos_;
+            return details::ReadCompareOperator(c);
+        }
+    }
+
+    if (details::IsIdentStart(c)) {
+        const size_t start = line_pos_ - 1;
+
+        // Плотный цикл без ветвлений по виду символа: принадлежность
+        // идентификатору - одно чтение из таблицы классов
+        while (line_pos_ < line_view_.size() && details::IsIdentChar(line_view_[line_pos_])) {
+            ++line_pos_;
+        }
+
+        // Идентификатор передаётся срезом буфера: интернирование в таблице
+        // символов обходится без промежуточной строки
+        return details::ReadKeyword(line_view_.substr(start, line_pos_ - start));
+    }
+
+    if (c == '"' || c == '\'') {
+        return ReadBufferString(c);
+    }
+
+    if (details::IsDigit(c)) {
+        const size_t start = line_pos_ - 1;
+
+        while (line_pos_ < line_view_.size() && details::IsDigit(line_view_[line_pos_])) {
+            ++line_pos_;
+        }
+
+        int number = 0;
+        const auto result =
+            from_chars(line_view_.data() + start, line_view_.data() + line_pos_, number);
+
+        if (result.ec == errc::result_out_of_range) {
+            details::ThrowNumberOutOfRange(line_view_.substr(start, line_pos_ - start),
+                                           line_view_);
+        }
+
+        return token_type::Number{number};
+    }
+
+    return token_type::Char{c};
+}
+
+token_type::String Lexer::ReadBufferString(char prefix) {
+    const size_t start = line_pos_;
+
+    // Частый случай - строка без экранирования: ищется закрывающая кавычка
+    // и значение копируется из буфера одним куском
+    while (line_pos_ < line_view_.size()) {
+        const char c = line_view_[line_pos_];
+
+        if (c == prefix) {
+            const auto raw = line_view_.substr(start, line_pos_ - start);
+            ++line_pos_;
+            return {string(raw)};
+        }
+
+        if (c == '\\') {
+            break;
+        }
+
+        ++line_pos_;
+    }
+
+    // Встретилось экранирование - значение собирается посимвольно
+    string s(line_view_.substr(start, line_pos_ - start));
+
+    while (line_pos_ < line_view_.size()) {
+        const char c = line_view_[line_pos_++];
+
+        if (c == prefix) {
+            break;
+        }
+
+        if (c == '\\') {
+            if (line_pos_ >= line_view_.size()) {
+                break;
+            }
+
+            switch (line_view_[line_pos_++]) {
+                case 'n':
+                    s.push_back('\n');
+                    break;
+                case 't':
+                    s.push_back('\t');
+                    break;
+                case 'r':
+                    s.push_back('\r');
+                    break;
+                case '\\':
+                    s.push_back('\\');
+                    break;
+                case '\'':
+                    s.push_back('\'');
+                    break;
+                case '"':
+                    s.push_back('"');
+                    break;
+            }
+        } else {
+            s.push_back(c);
+        }
+    }
+
+    return {move(s)};
+}
+
+void Lexer::ReadNextLineView() {
+    while (pos_ < source_.size()) {
+        size_t eol = source_.find('\n', pos_);
+
+        if (eol == string_view::npos) {
+            eol = source_.size();
+        }
+
+        const string_view line = source_.substr(pos_, eol - pos_);
+        pos_ = eol + 1;
+
+        if (!line.empty()) {
+            const auto first = line.find_first_not_of(' ');
+
+            if (first != string_view::npos && line[first] != '#') {
+                context_.new_indent = static_cast<int>(first / 2);
+                line_view_ = line;
+                line_pos_ = 0;
+                return;
+            }
+        }
+    }
+
+    // Строк больше нет: текущая строка пуста и уже исчерпана
+    line_view_ = {};
+    line_pos_ = 1;
+}
+
 }  // namespace parse
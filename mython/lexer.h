@@ -1,11 +1,15 @@
 #pragma once
 
+#include "symbol.h"
+
 #include <iosfwd>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 
 namespace parse {
 
@@ -14,8 +18,9 @@ struct Number {  // Лексема «число»
     int value;   // число
 };
 
-struct Id {             // Лексема «идентификатор»
-    std::string value;  // Имя идентификатора
+struct Id {                      // Лексема «идентификатор»
+    std::string value;           // Имя идентификатора
+    runtime::Symbol symbol = {}; // Интернированное имя, заполняется лексером
 };
 
 struct Char {    // Лексема «символ»
@@ -46,6 +51,7 @@ struct GreaterOrEq {};  // Лексема «>=»
 struct None {};         // Лексема «None»
 struct True {};         // Лексема «True»
 struct False {};        // Лексема «False»
+struct While {};        // Лексема «while»
 }  // namespace token_type
 
 using TokenBase
@@ -54,7 +60,8 @@ using TokenBase
                    token_type::Def, token_type::Newline, token_type::Print, token_type::Indent,
                    token_type::Dedent, token_type::And, token_type::Or, token_type::Not,
                    token_type::Eq, token_type::NotEq, token_type::LessOrEq, token_type::GreaterOrEq,
-                   token_type::None, token_type::True, token_type::False, token_type::Eof>;
+                   token_type::None, token_type::True, token_type::False, token_type::While,
+                   token_type::Eof>;
 
 struct Token : TokenBase {
     using TokenBase::TokenBase;
@@ -94,28 +101,74 @@ public:
 
     explicit Lexer(std::istream& input);
 
+    // Лексер над сплошным буфером с исходным текстом (например, отображённым
+    // в память файлом). Сканирует буфер арифметикой указателей, не создавая
+    // потоков на строку и не читая по символу через виртуальные вызовы.
+    // Буфер должен жить, пока жив лексер
+    explicit Lexer(std::string_view source);
+
+    // Лексер над заранее записанным потоком токенов (например, загруженным
+    // из кэша компиляции). Никакой посимвольной работы не выполняется:
+    // токены выдаются из массива, после последнего возвращается Eof
+    explicit Lexer(std::vector<Token>&& tokens);
+
+    // Лексер-курсор над чужой записью токенов (см. cache::RecordTokens).
+    // Запись не копируется и должна жить, пока жив лексер; несколько
+    // курсоров могут одновременно читать одну запись. Вместе с Rewind
+    // позволяет разбирать одну и ту же запись многократно, не платя
+    // за посимвольную работу и копирование токенов
+    explicit Lexer(const std::vector<Token>& tokens);
+
+    // Перематывает воспроизведение к началу записи за O(1). Допустим
+    // только в режиме воспроизведения, иначе бросает LexerError
+    void Rewind();
+
     // Возвращает ссылку на текущий токен или token_type::Eof, если поток токенов закончился
     [[nodiscard]] const Token& CurrentToken() const;
 
     // Возвращает следующий токен, либо token_type::Eof, если поток токенов закончился
     Token NextToken();
 
-    // Если текущий токен имеет тип T, метод возвращает ссылку на него.
-    // В противном случае метод выбрасывает исключение LexerError
+    // Если текущий токен имеет тип T, возвращает указатель на него,
+    // иначе nullptr. Не бросает исключений и не строит диагностик -
+    // примитив для горячего пути парсера
     template <typename T>
-    const T& Expect() const {
-        using namespace std::literals;
+    [[nodiscard]] const T* TryExpect() const {
+        return current_token_.TryAs<T>();
+    }
 
-        try{
-            return CurrentToken().As<T>();
-        } catch(...) {
-            std::stringstream s;
+    // Если текущий токен имеет тип T, поглощает его и возвращает true,
+    // иначе оставляет поток на месте и возвращает false
+    template <typename T>
+    bool ConsumeIf() {
+        if (current_token_.Is<T>()) {
+            NextToken();
+            return true;
+        }
 
-            s << typeid(T).name()
-              << " is expected"s;
+        return false;
+    }
 
-            throw LexerError(s.str());
+    // То же, но токен должен ещё и содержать значение value
+    template <typename T, typename U>
+    bool ConsumeIf(const U& value) {
+        if (const T* token = TryExpect<T>(); token != nullptr && token->value == value) {
+            NextToken();
+            return true;
+        }
+
+        return false;
+    }
+
+    // Если текущий токен имеет тип T, метод возвращает ссылку на него.
+    // В противном случае метод выбрасывает исключение LexerError
+    template <typename T>
+    const T& Expect() const {
+        if (const T* token = TryExpect<T>()) {
+            return *token;
         }
+
+        ThrowExpectError(typeid(T).name());
     }
 
     // Метод проверяет, что текущий токен имеет тип T, а сам токен содержит значение value.
@@ -152,12 +205,37 @@ public:
     }
 
 private:
+    // Холодный путь Expect: собирает диагностику и бросает LexerError
+    [[noreturn]] static void ThrowExpectError(const char* type_name);
+
     static std::istringstream ReadNextLine(std::istream& input, Context& context);
 
     Token ReadToken();
-
-    std::istream& input_;
+    // Читает токен в потоковом режиме (построчно через istringstream)
+    Token ReadStreamToken();
+    // Читает токен в буферном режиме (сканирование source_ по индексам)
+    Token ReadBufferToken();
+    // Читает строковую константу в буферном режиме
+    token_type::String ReadBufferString(char prefix);
+    // Находит в буфере следующую непустую строку без комментария
+    // и делает её текущей
+    void ReadNextLineView();
+
+    std::istream* input_ = nullptr;
     std::istringstream line_;
+    // Буферный режим: исходный текст, позиция чтения и текущая строка.
+    // line_pos_ == line_view_.size() означает «виртуальный \n» в конце строки,
+    // большее значение - строка исчерпана
+    std::string_view source_;
+    std::size_t pos_ = 0;
+    std::string_view line_view_;
+    std::size_t line_pos_ = 1;
+    // Режим воспроизведения: читаемая запись токенов и позиция чтения.
+    // Запись либо принадлежит лексеру (recorded_), либо внешняя
+    std::vector<Token> recorded_;
+    const std::vector<Token>* replay_source_ = nullptr;
+    std::size_t replay_pos_ = 0;
+    bool replay_ = false;
     Token current_token_;
     Context context_;
 };
@@ -41,7 +41,7 @@ void TestKeywords() {
 }
 
 void TestNumbers() {
-    istringstream input("42 15 -53"s);
+    istringstream input("42 15 -53 000000000000000042 000"s);
     Lexer lexer(input);
 
     ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Number{42}));
@@ -49,6 +49,24 @@ void TestNumbers() {
     // Отрицательные числа формируются на этапе синтаксического анализа
     ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'-'}));
     ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{53}));
+    // Ведущие нули не считаются значащими цифрами
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{42}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{0}));
+}
+
+void TestNumberOutOfRange() {
+    // Литерал, не помещающийся в int, - ошибка лексера в обоих сканерах
+    istringstream input("99999999999999999999"s);
+
+    try {
+        Lexer lexer(input);
+        ASSERT(false);
+    } catch (const LexerError& error) {
+        // Диагностика называет литерал целиком, а не усечённый префикс
+        ASSERT(string(error.what()).find("99999999999999999999"s) != string::npos);
+    }
+
+    ASSERT_THROWS(Lexer{"99999999999999999999"sv}, LexerError);
 }
 
 void TestIds() {
@@ -351,12 +369,49 @@ abc#
         ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
     }
 }
+
+void TestBufferLexerMatchesStreamLexer() {
+    const string source = R"(
+x = 4
+y = "hello\n"  # escape-последовательности и комментарии
+
+class Point:
+  def __init__(self, x, y):
+    self.x = x
+    self.y = y
+
+  def __str__(self):
+    return str(x) + ' ' + str(y)
+
+p = Point(1, 2)
+padded = 000000000000000042
+if x <= 4:
+  print str(p), x != 0
+)"s;
+
+    istringstream input(source);
+    Lexer stream_lexer(input);
+    Lexer buffer_lexer{string_view(source)};
+
+    // Буферный лексер выдаёт ту же последовательность токенов, что и потоковый
+    while (true) {
+        ASSERT_EQUAL(buffer_lexer.CurrentToken(), stream_lexer.CurrentToken());
+
+        if (stream_lexer.CurrentToken().Is<token_type::Eof>()) {
+            break;
+        }
+
+        stream_lexer.NextToken();
+        buffer_lexer.NextToken();
+    }
+}
 }  // namespace
 
 void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestSimpleAssignment);
     RUN_TEST(tr, parse::TestKeywords);
     RUN_TEST(tr, parse::TestNumbers);
+    RUN_TEST(tr, parse::TestNumberOutOfRange);
     RUN_TEST(tr, parse::TestIds);
     RUN_TEST(tr, parse::TestStrings);
     RUN_TEST(tr, parse::TestOperations);
@@ -367,6 +422,7 @@ void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestMythonProgram);
     RUN_TEST(tr, parse::TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine);
     RUN_TEST(tr, parse::TestCommentsAreIgnored);
+    RUN_TEST(tr, parse::TestBufferLexerMatchesStreamLexer);
 }
 
 }  // namespace parse
\ No newline at end of file
@@ -1,140 +1,122 @@
-#include "lexer.h"
-#include "parse.h"
-#include "runtime.h"
-#include "statement.h"
-#include "test_runner_p.h"
+#include "interpreter.h"
+#include "interpreter_pool.h"
+#include "profiler.h"
 
+#include <charconv>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 using namespace std;
 
-namespace parse {
-void RunOpenLexerTests(TestRunner& tr);
-}  // namespace parse
-
-namespace ast {
-void RunUnitTests(TestRunner& tr);
-}
-namespace runtime {
-void RunObjectHolderTests(TestRunner& tr);
-void RunObjectsTests(TestRunner& tr);
-}  // namespace runtime
-
-void TestParseProgram(TestRunner& tr);
-
 namespace {
 
-void RunMythonProgram(istream& input, ostream& output) {
-    parse::Lexer lexer(input);
-    auto program = ParseProgram(lexer);
-
-    runtime::SimpleContext context{output};
-    runtime::Closure closure;
-    program->Execute(closure, context);
-}
-
-void TestSimplePrints() {
-    istringstream input(R"(
-print 57
-print 10, 24, -8
-print 'hello'
-print "world"
-print True, False
-print
-print None
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
-}
+// Параметры запуска: mython [--prelude FILE] [-jN] [SCRIPT...]
+// Без скриптов программа читается со стандартного ввода
+struct Options {
+    const char* prelude = nullptr;
+    size_t jobs = 1;
+    vector<const char*> scripts;
+};
+
+Options ParseArgs(int argc, char* argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+
+        if (arg == "--prelude"sv) {
+            if (++i >= argc) {
+                throw runtime_error("--prelude requires a file argument"s);
+            }
+
+            options.prelude = argv[i];
+        } else if (arg.size() > 2 && arg.substr(0, 2) == "-j"sv) {
+            size_t jobs = 0;
+            const auto* last = arg.data() + arg.size();
+
+            if (from_chars(arg.data() + 2, last, jobs).ptr != last || jobs == 0) {
+                throw runtime_error("Invalid worker count: "s + string(arg));
+            }
+
+            options.jobs = jobs;
+        } else {
+            options.scripts.push_back(argv[i]);
+        }
+    }
 
-void TestAssignments() {
-    istringstream input(R"(
-x = 57
-print x
-x = 'C++ black belt'
-print x
-y = False
-x = y
-print x
-x = None
-print x, y
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
+    return options;
 }
 
-void TestArithmetics() {
-    istringstream input("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2");
+shared_ptr<const pool::SharedProgram> LoadSharedProgram(const char* path) {
+    ifstream input(path);
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+    if (!input) {
+        throw runtime_error("Cannot open file "s + path);
+    }
 
-    ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
+    return make_shared<const pool::SharedProgram>(input);
 }
 
-void TestVariablesArePointers() {
-    istringstream input(R"(
-class Counter:
-  def __init__():
-    self.value = 0
+// Пакетный режим: прелюдия разбирается по разу на рабочий поток, скрипты
+// исполняются против свежих замыканий, засеянных её именами. Вывод
+// печатается в порядке перечисления скриптов
+int RunBatch(const Options& options) {
+    shared_ptr<const pool::SharedProgram> prelude;
 
-  def add():
-    self.value = self.value + 1
-
-class Dummy:
-  def do_add(counter):
-    counter.add()
-
-x = Counter()
-y = x
-
-x.add()
-y.add()
+    if (options.prelude) {
+        prelude = LoadSharedProgram(options.prelude);
+    }
 
-print x.value
+    pool::InterpreterPool pool(options.jobs, move(prelude));
 
-d = Dummy()
-d.do_add(x)
+    vector<future<string>> results;
+    results.reserve(options.scripts.size());
 
-print y.value
-)");
+    for (const char* path : options.scripts) {
+        results.push_back(pool.Submit(LoadSharedProgram(path)));
+    }
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+    int exit_code = 0;
 
-    ASSERT_EQUAL(output.str(), "2\n3\n");
-}
+    for (size_t i = 0; i < results.size(); ++i) {
+        try {
+            cout << results[i].get();
+        } catch (const exception& e) {
+            cerr << options.scripts[i] << ": " << e.what() << endl;
+            exit_code = 1;
+        }
+    }
 
-void TestAll() {
-    TestRunner tr;
-    parse::RunOpenLexerTests(tr);
-    runtime::RunObjectHolderTests(tr);
-    runtime::RunObjectsTests(tr);
-    ast::RunUnitTests(tr);
-    TestParseProgram(tr);
-
-    RUN_TEST(tr, TestSimplePrints);
-    RUN_TEST(tr, TestAssignments);
-    RUN_TEST(tr, TestArithmetics);
-    RUN_TEST(tr, TestVariablesArePointers);
+    return exit_code;
 }
 
 }  // namespace
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        TestAll();
+        const auto options = ParseArgs(argc, argv);
+
+        int exit_code = 0;
 
-        RunMythonProgram(cin, cout);
+        if (options.prelude || options.jobs > 1 || options.scripts.size() > 1) {
+            exit_code = RunBatch(options);
+        } else if (!options.scripts.empty()) {
+            RunMythonFile(options.scripts.front(), cout);
+        } else {
+            RunMythonProgram(cin, cout);
+        }
+
+        // Пустой вызов без -DMYTHON_PROFILE
+        profile::Dump(cerr);
+        return exit_code;
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
-		return 1;
+        return 1;
     }
     return 0;
-}
\ No newline at end of file
+}
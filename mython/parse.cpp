@@ -2,6 +2,7 @@
 
 #include "lexer.h"
 #include "statement.h"
+#include "vm.h"
 
 using namespace std;
 
@@ -23,6 +24,17 @@ public:
         : lexer_(lexer) {
     }
 
+    Parser(parse::Lexer& lexer, const runtime::Closure& environment)
+        : lexer_(lexer) {
+        // Классы окружения доступны разбору: вызов Name(...) для них
+        // превращается в NewInstance, как и для классов самой программы
+        for (const auto& [name, value] : environment) {
+            if (value.TryAs<runtime::Class>() != nullptr) {
+                declared_classes_.insert({name, value});
+            }
+        }
+    }
+
     // Program -> eps
     //          | Statement \n Program
     unique_ptr<ast::Statement> ParseProgram() {
@@ -34,6 +46,20 @@ public:
         return result;
     }
 
+    // Возвращает очередную инструкцию верхнего уровня либо nullptr на Eof.
+    // contains_class выставляется, если внутри инструкции объявлен класс -
+    // такую инструкцию нельзя уничтожать до конца исполнения программы
+    unique_ptr<ast::Statement> ParseTopLevelStatement(bool& contains_class) {
+        if (lexer_.CurrentToken().Is<TokenType::Eof>()) {
+            return nullptr;
+        }
+
+        const size_t known_classes = declared_classes_.size();
+        auto statement = ParseStatement();
+        contains_class = declared_classes_.size() > known_classes;
+        return statement;
+    }
+
 private:
     // Suite -> NEWLINE INDENT (Statement)+ DEDENT
     unique_ptr<ast::Statement> ParseSuite()  // NOLINT
@@ -124,11 +150,11 @@ private:
         return make_unique<ast::ClassDefinition>(it->second);
     }
 
-    vector<string> ParseDottedIds() {
-        vector<string> result(1, lexer_.Expect<TokenType::Id>().value);
+    vector<runtime::Symbol> ParseDottedIds() {
+        vector<runtime::Symbol> result(1, lexer_.Expect<TokenType::Id>().symbol);
 
         while (lexer_.NextToken() == '.') {
-            result.push_back(lexer_.ExpectNext<TokenType::Id>().value);
+            result.push_back(lexer_.ExpectNext<TokenType::Id>().symbol);
         }
 
         return result;
@@ -139,24 +165,23 @@ private:
     unique_ptr<ast::Statement> ParseAssignmentOrCall() {
         lexer_.Expect<TokenType::Id>();
 
-        vector<string> id_list = ParseDottedIds();
-        string last_name = id_list.back();
+        vector<runtime::Symbol> id_list = ParseDottedIds();
+        runtime::Symbol last_name = id_list.back();
         id_list.pop_back();
 
-        if (lexer_.CurrentToken() == '=') {
-            lexer_.NextToken();
-
+        if (lexer_.ConsumeIf<TokenType::Char>('=')) {
             if (id_list.empty()) {
-                return make_unique<ast::Assignment>(std::move(last_name), ParseTest());
+                return make_unique<ast::Assignment>(last_name, ParseTest());
             }
             return make_unique<ast::FieldAssignment>(ast::VariableValue{std::move(id_list)},
-                                                     std::move(last_name), ParseTest());
+                                                     last_name, ParseTest());
         }
         lexer_.Expect<TokenType::Char>('(');
         lexer_.NextToken();
 
         if (id_list.empty()) {
-            throw ParseError("Mython doesn't support functions, only methods: "s + last_name);
+            throw ParseError("Mython doesn't support functions, only methods: "s
+                             + last_name.GetName());
         }
 
         vector<unique_ptr<ast::Statement>> args;
@@ -167,41 +192,37 @@ private:
         lexer_.NextToken();
 
         return make_unique<ast::MethodCall>(make_unique<ast::VariableValue>(std::move(id_list)),
-                                            std::move(last_name), std::move(args));
+                                            last_name, std::move(args));
     }
 
     // Expr -> Adder ['+'/'-' Adder]*
     unique_ptr<ast::Statement> ParseExpression()  // NOLINT
     {
         unique_ptr<ast::Statement> result = ParseAdder();
-        while (lexer_.CurrentToken() == '+' || lexer_.CurrentToken() == '-') {
-            char op = lexer_.CurrentToken().As<TokenType::Char>().value;
-            lexer_.NextToken();
-
-            if (op == '+') {
+        for (;;) {
+            if (lexer_.ConsumeIf<TokenType::Char>('+')) {
                 result = make_unique<ast::Add>(std::move(result), ParseAdder());
-            } else {
+            } else if (lexer_.ConsumeIf<TokenType::Char>('-')) {
                 result = make_unique<ast::Sub>(std::move(result), ParseAdder());
+            } else {
+                return result;
             }
         }
-        return result;
     }
 
     // Adder -> Mult ['*'/'/' Mult]*
     unique_ptr<ast::Statement> ParseAdder()  // NOLINT
     {
         unique_ptr<ast::Statement> result = ParseMult();
-        while (lexer_.CurrentToken() == '*' || lexer_.CurrentToken() == '/') {
-            char op = lexer_.CurrentToken().As<TokenType::Char>().value;
-            lexer_.NextToken();
-
-            if (op == '*') {
+        for (;;) {
+            if (lexer_.ConsumeIf<TokenType::Char>('*')) {
                 result = make_unique<ast::Mult>(std::move(result), ParseMult());
-            } else {
+            } else if (lexer_.ConsumeIf<TokenType::Char>('/')) {
                 result = make_unique<ast::Div>(std::move(result), ParseMult());
+            } else {
+                return result;
             }
         }
-        return result;
     }
 
     // Mult -> '(' Expr ')'
@@ -215,37 +236,39 @@ private:
     //       | DottedIds
     unique_ptr<ast::Statement> ParseMult()  // NOLINT
     {
-        if (lexer_.CurrentToken() == '(') {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::Char>('(')) {
             auto result = ParseTest();
             lexer_.Expect<TokenType::Char>(')');
             lexer_.NextToken();
             return result;
         }
-        if (lexer_.CurrentToken() == '-') {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::Char>('-')) {
+            // Отрицательный числовой литерал сворачивается в константу
+            // прямо при разборе - без узла Mult(x, -1) на каждый -N
+            if (const auto* num = lexer_.TryExpect<TokenType::Number>()) {
+                const int value = num->value;
+                lexer_.NextToken();
+                return make_unique<ast::NumericConst>(-value);
+            }
             return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
         }
-        if (const auto* num = lexer_.CurrentToken().TryAs<TokenType::Number>()) {
+        if (const auto* num = lexer_.TryExpect<TokenType::Number>()) {
             int result = num->value;
             lexer_.NextToken();
             return make_unique<ast::NumericConst>(result);
         }
-        if (const auto* str = lexer_.CurrentToken().TryAs<TokenType::String>()) {
+        if (const auto* str = lexer_.TryExpect<TokenType::String>()) {
             string result = str->value;
             lexer_.NextToken();
             return make_unique<ast::StringConst>(std::move(result));
         }
-        if (lexer_.CurrentToken().Is<TokenType::True>()) {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::True>()) {
             return make_unique<ast::BoolConst>(runtime::Bool(true));
         }
-        if (lexer_.CurrentToken().Is<TokenType::False>()) {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::False>()) {
             return make_unique<ast::BoolConst>(runtime::Bool(false));
         }
-        if (lexer_.CurrentToken().Is<TokenType::None>()) {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::None>()) {
             return make_unique<ast::None>();
         }
 
@@ -253,7 +276,7 @@ private:
     }
 
     std::unique_ptr<ast::Statement> ParseDottedIdsInMultExpr() {
-        vector<string> names = ParseDottedIds();
+        vector<runtime::Symbol> names = ParseDottedIds();
 
         if (lexer_.CurrentToken() == '(') {
             // various calls
@@ -269,20 +292,20 @@ private:
 
             if (!names.empty()) {
                 return make_unique<ast::MethodCall>(
-                    make_unique<ast::VariableValue>(std::move(names)), std::move(method_name),
+                    make_unique<ast::VariableValue>(std::move(names)), method_name,
                     std::move(args));
             }
             if (auto it = declared_classes_.find(method_name); it != declared_classes_.end()) {
                 return make_unique<ast::NewInstance>(
                     static_cast<const runtime::Class&>(*it->second), std::move(args));  // NOLINT
             }
-            if (method_name == "str"sv) {
+            if (method_name.GetName() == "str"sv) {
                 if (args.size() != 1) {
                     throw ParseError("Function str takes exactly one argument"s);
                 }
                 return make_unique<ast::Stringify>(std::move(args.front()));
             }
-            throw ParseError("Unknown call to "s + method_name + "()"s);
+            throw ParseError("Unknown call to "s + method_name.GetName() + "()"s);
         }
         return make_unique<ast::VariableValue>(std::move(names));
     }
@@ -292,8 +315,7 @@ private:
         vector<unique_ptr<ast::Statement>> result;
         result.push_back(ParseTest());
 
-        while (lexer_.CurrentToken() == ',') {
-            lexer_.NextToken();
+        while (lexer_.ConsumeIf<TokenType::Char>(',')) {
             result.push_back(ParseTest());
         }
         return result;
@@ -313,8 +335,8 @@ private:
         auto if_body = ParseSuite();
 
         unique_ptr<ast::Statement> else_body;
-        if (lexer_.CurrentToken().Is<TokenType::Else>()) {
-            lexer_.ExpectNext<TokenType::Char>(':');
+        if (lexer_.ConsumeIf<TokenType::Else>()) {
+            lexer_.Expect<TokenType::Char>(':');
             lexer_.NextToken();
             else_body = ParseSuite();
         }
@@ -323,6 +345,22 @@ private:
                                         std::move(else_body));
     }
 
+    // WhileLoop -> while LogicalExpr: Suite
+    unique_ptr<ast::Statement> ParseWhileLoop()  // NOLINT
+    {
+        lexer_.Expect<TokenType::While>();
+        lexer_.NextToken();
+
+        auto condition = ParseTest();
+
+        lexer_.Expect<TokenType::Char>(':');
+        lexer_.NextToken();
+
+        auto body = ParseSuite();
+
+        return make_unique<ast::While>(std::move(condition), std::move(body));
+    }
+
     // LogicalExpr -> AndTest [OR AndTest]
     // AndTest -> NotTest [AND NotTest]
     // NotTest -> [NOT] NotTest
@@ -330,8 +368,7 @@ private:
     unique_ptr<ast::Statement> ParseTest()  // NOLINT
     {
         auto result = ParseAndTest();
-        while (lexer_.CurrentToken().Is<TokenType::Or>()) {
-            lexer_.NextToken();
+        while (lexer_.ConsumeIf<TokenType::Or>()) {
             result = make_unique<ast::Or>(std::move(result), ParseAndTest());
         }
         return result;
@@ -340,8 +377,7 @@ private:
     unique_ptr<ast::Statement> ParseAndTest()  // NOLINT
     {
         auto result = ParseNotTest();
-        while (lexer_.CurrentToken().Is<TokenType::And>()) {
-            lexer_.NextToken();
+        while (lexer_.ConsumeIf<TokenType::And>()) {
             result = make_unique<ast::And>(std::move(result), ParseNotTest());
         }
         return result;
@@ -349,8 +385,7 @@ private:
 
     unique_ptr<ast::Statement> ParseNotTest()  // NOLINT
     {
-        if (lexer_.CurrentToken().Is<TokenType::Not>()) {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::Not>()) {
             return make_unique<ast::Not>(ParseNotTest());  // NOLINT
         }
         return ParseComparison();
@@ -361,36 +396,28 @@ private:
     {
         auto result = ParseExpression();
 
-        const auto tok = lexer_.CurrentToken();
-
-        if (tok == '<') {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Less, std::move(result),
+        if (lexer_.ConsumeIf<TokenType::Char>('<')) {
+            return make_unique<ast::Comparison<runtime::Less>>(std::move(result),
                                                 ParseExpression());
         }
-        if (tok == '>') {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Greater, std::move(result),
+        if (lexer_.ConsumeIf<TokenType::Char>('>')) {
+            return make_unique<ast::Comparison<runtime::Greater>>(std::move(result),
                                                 ParseExpression());
         }
-        if (tok.Is<TokenType::Eq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Equal, std::move(result),
+        if (lexer_.ConsumeIf<TokenType::Eq>()) {
+            return make_unique<ast::Comparison<runtime::Equal>>(std::move(result),
                                                 ParseExpression());
         }
-        if (tok.Is<TokenType::NotEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::NotEqual, std::move(result),
+        if (lexer_.ConsumeIf<TokenType::NotEq>()) {
+            return make_unique<ast::Comparison<runtime::NotEqual>>(std::move(result),
                                                 ParseExpression());
         }
-        if (tok.Is<TokenType::LessOrEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::LessOrEqual, std::move(result),
+        if (lexer_.ConsumeIf<TokenType::LessOrEq>()) {
+            return make_unique<ast::Comparison<runtime::LessOrEqual>>(std::move(result),
                                                 ParseExpression());
         }
-        if (tok.Is<TokenType::GreaterOrEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::GreaterOrEqual, std::move(result),
+        if (lexer_.ConsumeIf<TokenType::GreaterOrEq>()) {
+            return make_unique<ast::Comparison<runtime::GreaterOrEqual>>(std::move(result),
                                                 ParseExpression());
         }
         return result;
@@ -399,17 +426,18 @@ private:
     // Statement -> SimpleStatement Newline
     //           | class ClassDefinition
     //           | if Condition
+    //           | while WhileLoop
     unique_ptr<ast::Statement> ParseStatement()  // NOLINT
     {
-        const auto& tok = lexer_.CurrentToken();
-
-        if (tok.Is<TokenType::Class>()) {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::Class>()) {
             return ParseClassDefinition();  // NOLINT
         }
-        if (tok.Is<TokenType::If>()) {
+        if (lexer_.CurrentToken().Is<TokenType::If>()) {
             return ParseCondition();
         }
+        if (lexer_.CurrentToken().Is<TokenType::While>()) {
+            return ParseWhileLoop();
+        }
         auto result = ParseSimpleStatement();
         lexer_.Expect<TokenType::Newline>();
         lexer_.NextToken();
@@ -420,14 +448,10 @@ private:
     //               | print ExpressionList
     //               | AssignmentOrCall
     unique_ptr<ast::Statement> ParseSimpleStatement() {
-        const auto& tok = lexer_.CurrentToken();
-
-        if (tok.Is<TokenType::Return>()) {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::Return>()) {
             return make_unique<ast::Return>(ParseTest());
         }
-        if (tok.Is<TokenType::Print>()) {
-            lexer_.NextToken();
+        if (lexer_.ConsumeIf<TokenType::Print>()) {
             vector<unique_ptr<ast::Statement>> args;
             if (!lexer_.CurrentToken().Is<TokenType::Newline>()) {
                 args = ParseTestList();
@@ -444,5 +468,34 @@ private:
 }  // namespace
 
 unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer) {
-    return Parser{lexer}.ParseProgram();
+    // Дерево упрощается свёрткой констант и транслируется в байт-код;
+    // фасад vm::Program выполняет его через прежний интерфейс Executable
+    return make_unique<vm::Program>(ast::Fold(Parser{lexer}.ParseProgram()));
+}
+
+unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer,
+                                             const runtime::Closure& environment) {
+    return make_unique<vm::Program>(ast::Fold(Parser{lexer, environment}.ParseProgram()));
+}
+
+void ParseAndExecuteProgram(parse::Lexer& lexer, runtime::Closure& closure,
+                            runtime::Context& context) {
+    Parser parser{lexer};
+
+    // Деревья с определениями классов доживают до конца программы:
+    // на них продолжают ссылаться созданные объекты Class
+    vector<unique_ptr<runtime::Executable>> class_definitions;
+
+    bool contains_class = false;
+
+    while (auto statement = parser.ParseTopLevelStatement(contains_class)) {
+        // Каждая инструкция сворачивается и транслируется отдельно -
+        // результат предыдущих уже исполнен и не нужен
+        auto program = make_unique<vm::Program>(ast::Fold(std::move(statement)));
+        program->Execute(closure, context);
+
+        if (contains_class) {
+            class_definitions.push_back(std::move(program));
+        }
+    }
 }
\ No newline at end of file
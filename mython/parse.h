@@ -8,11 +8,27 @@ class Lexer;
 }
 
 namespace runtime {
+class Closure;
+class Context;
 class Executable;
-}
+}  // namespace runtime
 
 struct ParseError : std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
-std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
\ No newline at end of file
+std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
+
+// То же, но классы из environment (например, замыкания исполненной
+// прелюдии) видны разбору наравне с объявленными в самой программе
+std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer,
+                                                  const runtime::Closure& environment);
+
+// Потоковый режим: разбирает и сразу исполняет программу по одной
+// инструкции верхнего уровня, не строя дерево программы целиком.
+// Исполненные инструкции уничтожаются немедленно, поэтому пиковая память
+// ограничена самой крупной инструкцией; живыми до конца остаются только
+// инструкции с определениями классов - объекты Class исполняют тела
+// методов по указателям внутрь их деревьев
+void ParseAndExecuteProgram(parse::Lexer& lexer, runtime::Closure& closure,
+                            runtime::Context& context);
\ No newline at end of file
@@ -191,6 +191,30 @@ print ok
     ASSERT_EQUAL(context.output.str(), "False\n"s);
 }
 
+void TestNotOnVariable() {
+    // not над неконстантным операндом не сворачивается при разборе
+    // и доходит до инструкции Not виртуальной машины
+    const string program = R"(
+x = 0
+done = False
+steps = 0
+while not done:
+  steps = steps + 1
+  done = steps > 2
+if not x:
+  print "zero", steps
+print not steps
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "zero 3\nFalse\n"s);
+}
+
 void TestClassicalPolymorphism() {
     const string program = R"(
 class Shape:
@@ -266,6 +290,31 @@ x = X(xh)
     ASSERT_EQUAL(xh->Fields().at("x"s).Get(), closure.at("x"s).Get());
 }
 
+void TestStreamingExecution() {
+    // Класс объявлен в начале, а используется после: дерево определения
+    // должно пережить уничтожение остальных исполненных инструкций
+    const string program = R"(
+print 1
+class Greeter:
+  def greet(name):
+    return "Hello, " + name
+
+g = Greeter()
+print g.greet("world")
+x = 2
+print x + 3
+)"s;
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+
+    istringstream is(program);
+    parse::Lexer lexer(is);
+    ParseAndExecuteProgram(lexer, closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "1\nHello, world\n5\n"s);
+}
+
 }  // namespace parse
 
 void TestParseProgram(TestRunner& tr) {
@@ -276,6 +325,8 @@ void TestParseProgram(TestRunner& tr) {
     RUN_TEST(tr, parse::TestRecursion);
     RUN_TEST(tr, parse::TestRecursion2);
     RUN_TEST(tr, parse::TestComplexLogicalExpression);
+    RUN_TEST(tr, parse::TestNotOnVariable);
     RUN_TEST(tr, parse::TestClassicalPolymorphism);
     RUN_TEST(tr, parse::TestSelfInConstructor);
+    RUN_TEST(tr, parse::TestStreamingExecution);
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "profiler.h"
+
+#ifdef MYTHON_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace profile {
+
+// Счётчики атомарные с расслабленным порядком: рабочие потоки пула
+// инкрементируют их одновременно, точность отчёта от этого не страдает
+struct Counter {
+    explicit Counter(string name) :
+        name(move(name)) {
+    }
+
+    string name;
+    atomic<unsigned long long> count{0};
+    atomic<unsigned long long> nanos{0};
+};
+
+namespace {
+
+// Дека даёт стабильные адреса счётчиков; мьютекс нужен только
+// при регистрации категории, не при инкременте
+struct Registry {
+    mutex guard;
+    deque<Counter> counters;
+    map<string, Counter*, less<>> by_name;
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+long long Now() {
+    return chrono::steady_clock::now().time_since_epoch().count();
+}
+
+}  // namespace
+
+Counter& RegisterCounter(const char* name) {
+    return MethodCounter(name);
+}
+
+Counter& MethodCounter(const string& name) {
+    auto& registry = GetRegistry();
+    lock_guard lock(registry.guard);
+
+    if (auto it = registry.by_name.find(name); it != registry.by_name.end()) {
+        return *it->second;
+    }
+
+    auto& counter = registry.counters.emplace_back(name);
+    registry.by_name.emplace(counter.name, &counter);
+    return counter;
+}
+
+void Hit(Counter& counter) {
+    counter.count.fetch_add(1, memory_order_relaxed);
+}
+
+ScopedTimer::ScopedTimer(Counter& counter) :
+    counter_(counter),
+    start_(Now()) {
+}
+
+ScopedTimer::~ScopedTimer() {
+    counter_.count.fetch_add(1, memory_order_relaxed);
+    counter_.nanos.fetch_add(static_cast<unsigned long long>(Now() - start_),
+                             memory_order_relaxed);
+}
+
+void Dump(ostream& out) {
+    auto& registry = GetRegistry();
+
+    vector<const Counter*> sorted;
+
+    {
+        lock_guard lock(registry.guard);
+        sorted.reserve(registry.counters.size());
+
+        for (const auto& counter : registry.counters) {
+            if (counter.count.load(memory_order_relaxed) > 0) {
+                sorted.push_back(&counter);
+            }
+        }
+    }
+
+    sort(sorted.begin(), sorted.end(), [](const Counter* lhs, const Counter* rhs) {
+        return lhs->nanos.load(memory_order_relaxed) > rhs->nanos.load(memory_order_relaxed);
+    });
+
+    out << "=== Mython profile ===\n";
+
+    for (const Counter* counter : sorted) {
+        const auto count = counter->count.load(memory_order_relaxed);
+        const auto nanos = counter->nanos.load(memory_order_relaxed);
+
+        out << counter->name << ": " << count << " calls";
+
+        if (nanos > 0) {
+            out << ", " << nanos / 1'000'000.0 << " ms total, "
+                << static_cast<double>(nanos) / static_cast<double>(count) << " ns/call";
+        }
+
+        out << '\n';
+    }
+}
+
+void Reset() {
+    auto& registry = GetRegistry();
+    lock_guard lock(registry.guard);
+
+    for (auto& counter : registry.counters) {
+        counter.count.store(0, memory_order_relaxed);
+        counter.nanos.store(0, memory_order_relaxed);
+    }
+}
+
+}  // namespace profile
+
+#endif  // MYTHON_PROFILE
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+
+/*
+ * Слой инструментирования исполнения. Включается флагом сборки
+ * -DMYTHON_PROFILE; собираются счётчики срабатываний и суммарные времена
+ * по категориям (типы AST-узлов, вызываемые методы, аллокации объектов),
+ * а Dump печатает отсортированный по времени отчёт о горячих местах.
+ *
+ * Без флага все макросы раскрываются в пустые выражения, а функции -
+ * в пустые инлайны: инструментированный код компилируется в тот же
+ * машинный код, что и до инструментирования
+ */
+
+namespace profile {
+
+#ifdef MYTHON_PROFILE
+
+struct Counter;
+
+// Регистрирует статическую категорию (имя должно жить вечно)
+Counter& RegisterCounter(const char* name);
+
+// Счётчик вызова метода по имени; категория создаётся при первом обращении
+Counter& MethodCounter(const std::string& name);
+
+void Hit(Counter& counter);
+
+// Печатает категории, отсортированные по суммарному времени
+void Dump(std::ostream& out);
+
+// Обнуляет все счётчики
+void Reset();
+
+// Прибавляет к счётчику время своей жизни
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Counter& counter);
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer();
+
+private:
+    Counter& counter_;
+    long long start_;
+};
+
+#define MYTHON_PROFILE_SCOPE(name)                                                  \
+    static ::profile::Counter& mython_profile_counter = ::profile::RegisterCounter(name); \
+    ::profile::ScopedTimer mython_profile_timer { mython_profile_counter }
+
+#define MYTHON_PROFILE_METHOD(name) \
+    ::profile::ScopedTimer mython_profile_timer { ::profile::MethodCounter(name) }
+
+#define MYTHON_PROFILE_COUNT(name)                                                        \
+    do {                                                                                  \
+        static ::profile::Counter& mython_profile_counter = ::profile::RegisterCounter(name); \
+        ::profile::Hit(mython_profile_counter);                                           \
+    } while (false)
+
+#else
+
+inline void Dump(std::ostream&) {
+}
+
+inline void Reset() {
+}
+
+#define MYTHON_PROFILE_SCOPE(name) static_cast<void>(0)
+#define MYTHON_PROFILE_METHOD(name) static_cast<void>(0)
+#define MYTHON_PROFILE_COUNT(name) static_cast<void>(0)
+
+#endif  // MYTHON_PROFILE
+
+}  // namespace profile
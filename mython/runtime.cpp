@@ -1,25 +1,142 @@
 #include "runtime.h"
 
+#include "profiler.h"
+
 #include <cassert>
+#include <new>
 #include <optional>
 #include <sstream>
+#include <unordered_set>
 #include <algorithm>
 
 using namespace std;
 
 namespace runtime {
 
-ObjectHolder::ObjectHolder(std::shared_ptr<Object> data)
-    : data_(std::move(data)) {
+ObjectHolder::ObjectHolder(Object* data, Tag tag)
+    : tag_(tag),
+      data_(data) {
+    if (tag_ == Tag::Data && data_ != nullptr) {
+        ++data_->ref_count_;
+    }
+}
+
+ObjectHolder::ObjectHolder(const ObjectHolder& other) {
+    CopyFrom(other);
+}
+
+ObjectHolder::ObjectHolder(ObjectHolder&& other) noexcept {
+    MoveFrom(std::move(other));
+}
+
+ObjectHolder& ObjectHolder::operator=(const ObjectHolder& other) {
+    if (this != &other) {
+        Reset();
+        CopyFrom(other);
+    }
+
+    return *this;
+}
+
+ObjectHolder& ObjectHolder::operator=(ObjectHolder&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        MoveFrom(std::move(other));
+    }
+
+    return *this;
+}
+
+ObjectHolder::~ObjectHolder() {
+    Reset();
+}
+
+void ObjectHolder::PlaceInline(Number number) {
+    tag_ = Tag::InlineNumber;
+    new (&inline_storage_) Number(std::move(number));
+}
+
+void ObjectHolder::PlaceInline(Bool value) {
+    tag_ = Tag::InlineBool;
+    new (&inline_storage_) Bool(std::move(value));
+}
+
+Object* ObjectHolder::GetInline() const {
+    return reinterpret_cast<Object*>(&inline_storage_);
+}
+
+void ObjectHolder::Reset() {
+    switch (tag_) {
+        case Tag::InlineNumber:
+            static_cast<Number*>(GetInline())->~Number();
+            break;
+        case Tag::InlineBool:
+            static_cast<Bool*>(GetInline())->~Bool();
+            break;
+        case Tag::Data:
+            if (data_ != nullptr && --data_->ref_count_ == 0) {
+                delete data_;
+            }
+            break;
+        case Tag::Borrowed:
+            break;
+    }
+
+    tag_ = Tag::Data;
+    data_ = nullptr;
+}
+
+void ObjectHolder::CopyFrom(const ObjectHolder& other) {
+    switch (other.tag_) {
+        case Tag::InlineNumber:
+            PlaceInline(*static_cast<const Number*>(other.GetInline()));
+            break;
+        case Tag::InlineBool:
+            PlaceInline(*static_cast<const Bool*>(other.GetInline()));
+            break;
+        case Tag::Data:
+            tag_ = Tag::Data;
+            data_ = other.data_;
+
+            if (data_ != nullptr) {
+                ++data_->ref_count_;
+            }
+            break;
+        case Tag::Borrowed:
+            tag_ = Tag::Borrowed;
+            data_ = other.data_;
+            break;
+    }
+}
+
+void ObjectHolder::MoveFrom(ObjectHolder&& other) noexcept {
+    switch (other.tag_) {
+        case Tag::InlineNumber:
+            PlaceInline(*static_cast<const Number*>(other.GetInline()));
+            break;
+        case Tag::InlineBool:
+            PlaceInline(*static_cast<const Bool*>(other.GetInline()));
+            break;
+        case Tag::Data:
+        case Tag::Borrowed:
+            // Счётчик ссылок не меняется: владение переходит этой обёртке
+            tag_ = other.tag_;
+            data_ = other.data_;
+            other.tag_ = Tag::Data;
+            other.data_ = nullptr;
+            return;
+    }
+
+    other.Reset();
 }
 
 void ObjectHolder::AssertIsValid() const {
-    assert(data_ != nullptr);
+    assert(Get() != nullptr);
 }
 
 ObjectHolder ObjectHolder::Share(Object& object) {
-    // Возвращаем невладеющий shared_ptr (его deleter ничего не делает)
-    return ObjectHolder(std::shared_ptr<Object>(&object, [](auto* /*p*/) { /* do nothing */ }));
+    // Невладеющая ссылка: счётчик объекта не затрагивается
+    return ObjectHolder(&object, Tag::Borrowed);
 }
 
 ObjectHolder ObjectHolder::None() {
@@ -37,34 +154,279 @@ Object* ObjectHolder::operator->() const {
 }
 
 Object* ObjectHolder::Get() const {
-    return data_.get();
+    return tag_ == Tag::Data || tag_ == Tag::Borrowed ? data_ : GetInline();
 }
 
 ObjectHolder::operator bool() const {
     return Get() != nullptr;
 }
 
+Closure::Closure(std::initializer_list<value_type> items) :
+    items_(items) {
+}
+
+size_t Closure::FindPos(Symbol name) const {
+    if (indexed_) {
+        auto it = index_.find(name);
+        return it != index_.end() ? it->second : NPOS;
+    }
+
+    for (size_t pos = 0; pos < items_.size(); ++pos) {
+        if (items_[pos].first == name) {
+            return pos;
+        }
+    }
+
+    return NPOS;
+}
+
+ObjectHolder& Closure::Append(Symbol name, ObjectHolder value) {
+    items_.emplace_back(name, std::move(value));
+
+    if (indexed_) {
+        index_.emplace(name, items_.size() - 1);
+    } else if (items_.size() > INDEX_THRESHOLD) {
+        indexed_ = true;
+
+        for (size_t pos = 0; pos < items_.size(); ++pos) {
+            index_.emplace(items_[pos].first, pos);
+        }
+    }
+
+    return items_.back().second;
+}
+
+ObjectHolder& Closure::operator[](Symbol name) {
+    if (const auto pos = FindPos(name); pos != NPOS) {
+        return items_[pos].second;
+    }
+
+    return Append(name, ObjectHolder::None());
+}
+
+ObjectHolder& Closure::at(Symbol name) {
+    if (const auto pos = FindPos(name); pos != NPOS) {
+        return items_[pos].second;
+    }
+
+    throw std::out_of_range("Name "s + name.GetName() + " is not found in closure"s);
+}
+
+const ObjectHolder& Closure::at(Symbol name) const {
+    return const_cast<Closure&>(*this).at(name);
+}
+
+size_t Closure::count(Symbol name) const {
+    return FindPos(name) != NPOS ? 1 : 0;
+}
+
+Closure::iterator Closure::find(Symbol name) {
+    const auto pos = FindPos(name);
+    return pos != NPOS ? items_.begin() + pos : items_.end();
+}
+
+Closure::const_iterator Closure::find(Symbol name) const {
+    const auto pos = FindPos(name);
+    return pos != NPOS ? items_.begin() + pos : items_.end();
+}
+
+pair<Closure::iterator, bool> Closure::insert(value_type item) {
+    if (const auto pos = FindPos(item.first); pos != NPOS) {
+        return {items_.begin() + pos, false};
+    }
+
+    Append(item.first, std::move(item.second));
+    return {items_.end() - 1, true};
+}
+
+void Closure::clear() {
+    items_.clear();
+    index_.clear();
+    indexed_ = false;
+}
+
+String::String(ObjectHolder lhs, ObjectHolder rhs, size_t size) :
+    Object(Type::String),
+    lhs_(move(lhs)),
+    rhs_(move(rhs)),
+    size_(size) {
+}
+
+ObjectHolder String::Concat(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+    const auto* left = lhs.TryAs<String>();
+    const auto* right = rhs.TryAs<String>();
+    const size_t size = left->Size() + right->Size();
+
+    // Пустые и короткие части не стоят узла верёвки
+    if (left->Size() == 0) {
+        return rhs;
+    }
+
+    if (right->Size() == 0) {
+        return lhs;
+    }
+
+    if (size <= SMALL_CONCAT) {
+        return MakeString(left->GetValue() + right->GetValue());
+    }
+
+    return ObjectHolder::Own(String(lhs, rhs, size));
+}
+
+void String::Flatten() const {
+    string result;
+    result.reserve(size_);
+
+    // Обход без рекурсии: правая часть кладётся в стек под левую,
+    // листья дописываются в результат слева направо
+    vector<const String*> pending;
+    pending.push_back(this);
+
+    while (!pending.empty()) {
+        const String* node = pending.back();
+        pending.pop_back();
+
+        if (node->lhs_) {
+            pending.push_back(node->rhs_.TryAs<String>());
+            pending.push_back(node->lhs_.TryAs<String>());
+        } else {
+            result += node->value_;
+        }
+    }
+
+    value_ = move(result);
+    lhs_ = ObjectHolder();
+    rhs_ = ObjectHolder();
+}
+
+const string& String::GetValue() const {
+    if (lhs_) {
+        Flatten();
+    }
+
+    return value_;
+}
+
+void String::Print(ostream& os, Context& /*context*/) {
+    os << GetValue();
+}
+
+void String::PrintTo(Context& context) {
+    context.Append(GetValue());
+}
+
+ObjectHolder& ResolveField(ClassInstance& instance, FieldSite& site) {
+    auto& fields = instance.Fields();
+
+    if (site.cls == &instance.GetClass() && site.slot < fields.size()) {
+        if (auto& slot = fields.Slot(site.slot); slot.first == site.name) {
+            return slot.second;
+        }
+    }
+
+    site.cls = &instance.GetClass();
+    site.slot = fields.FindSlot(site.name);
+
+    if (site.slot == Closure::NPOS) {
+        auto& value = fields[site.name];
+        site.slot = fields.size() - 1;
+        return value;
+    }
+
+    return fields.Slot(site.slot).second;
+}
+
+ObjectHolder* FindField(ClassInstance& instance, FieldSite& site) {
+    auto& fields = instance.Fields();
+
+    if (site.cls == &instance.GetClass() && site.slot < fields.size()) {
+        if (auto& slot = fields.Slot(site.slot); slot.first == site.name) {
+            return &slot.second;
+        }
+    }
+
+    site.cls = &instance.GetClass();
+    site.slot = fields.FindSlot(site.name);
+
+    if (site.slot == Closure::NPOS) {
+        return nullptr;
+    }
+
+    return &fields.Slot(site.slot).second;
+}
+
+ObjectHolder* ResolveName(Closure& closure, NameSite& site) {
+    if (site.slot < closure.size()) {
+        if (auto& slot = closure.Slot(site.slot); slot.first == site.name) {
+            return &slot.second;
+        }
+    }
+
+    site.slot = closure.FindSlot(site.name);
+
+    if (site.slot == Closure::NPOS) {
+        return nullptr;
+    }
+
+    return &closure.Slot(site.slot).second;
+}
+
 bool IsTrue(const ObjectHolder& object) {
     if (const auto* number = object.TryAs<Number>()) {
         return number->GetValue();
     } else if (const auto* boolean = object.TryAs<Bool>()) {
         return boolean->GetValue();
     } else if (const auto* str = object.TryAs<String>()) {
-        return !str->GetValue().empty();
+        return str->Size() != 0;
     }
 
     return false;
 }
 
+namespace {
+// Символы имён, используемых самим интерпретатором, интернируются один раз
+const Symbol SELF_NAME = "self"s;
+const Symbol STR_METHOD = "__str__"s;
+const Symbol EQ_METHOD = "__eq__"s;
+const Symbol LT_METHOD = "__lt__"s;
+}  // namespace
+
+void Object::PrintTo(Context& context) {
+    ostringstream os;
+    Print(os, context);
+    context.Append(os.str());
+}
+
+std::string Context::Represent(Object& object) {
+    // Буфер вывода на время печати подменяется пустым
+    string saved;
+    saved.swap(out_buffer_);
+    object.PrintTo(*this);
+    out_buffer_.swap(saved);
+    return saved;
+}
+
 void ClassInstance::Print(std::ostream& os, Context& context) {
-    if (HasMethod("__str__"s, 0)) {
-        Call("__str__"s, {}, context)->Print(os, context);
+    os << context.Represent(*this);
+}
+
+void ClassInstance::PrintTo(Context& context) {
+    const auto* method = cls_.GetMethod(STR_METHOD);
+
+    if (method && method->param_symbols.empty()) {
+        if (auto result = CallMethod(method, {}, context)) {
+            result->PrintTo(context);
+        } else {
+            context.Append("None");
+        }
     } else {
+        ostringstream os;
         os << this;
+        context.Append(os.str());
     }
 }
 
-bool ClassInstance::HasMethod(const std::string& method, size_t argument_count) const {
+bool ClassInstance::HasMethod(Symbol method, size_t argument_count) const {
     if (const auto* m = cls_.GetMethod(method)) {
         return m->formal_params.size() == argument_count;
     }
@@ -80,46 +442,179 @@ const Closure& ClassInstance::Fields() const {
     return fields_;
 }
 
+namespace {
+
+// Реестр живых экземпляров потока для сборщика циклов. Удаление -
+// перестановкой с последним элементом, позиция хранится в самом экземпляре
+vector<ClassInstance*>& GetInstanceRegistry() {
+    thread_local vector<ClassInstance*> registry;
+    return registry;
+}
+
+// Возвращает занятый кадр вызова в стек контекста при выходе из области
+struct FrameGuard {
+    Context& context;
+
+    ~FrameGuard() {
+        context.ReleaseFrame();
+    }
+};
+
+}  // namespace
+
+void ClassInstance::Register() {
+    auto& registry = GetInstanceRegistry();
+    registry_index_ = registry.size();
+    registry.push_back(this);
+}
+
 ClassInstance::ClassInstance(const Class& cls) :
+    Object(Type::ClassInstance),
     cls_(cls) {
+    Register();
 }
 
-ObjectHolder ClassInstance::Call(const std::string& method,
-                                 const std::vector<ObjectHolder>& actual_args,
-                                 Context& context) {
-    if (HasMethod(method, actual_args.size())) {
-        if (const auto* class_method = cls_.GetMethod(method)) {
-            Closure closure;
-            closure["self"s] = ObjectHolder::Share(*this);
-
-            for (size_t i = 0; i < actual_args.size(); ++i) {
-                const auto& param_name = class_method->formal_params[i];
-                closure[param_name] = actual_args[i];
-            }
+ClassInstance::ClassInstance(const ClassInstance& other) :
+    Object(Type::ClassInstance),
+    cls_(other.cls_),
+    fields_(other.fields_) {
+    Register();
+}
+
+ClassInstance::ClassInstance(ClassInstance&& other) noexcept :
+    Object(Type::ClassInstance),
+    cls_(other.cls_),
+    fields_(move(other.fields_)) {
+    Register();
+}
+
+ClassInstance::~ClassInstance() {
+    auto& registry = GetInstanceRegistry();
+    registry[registry_index_] = registry.back();
+    registry[registry_index_]->registry_index_ = registry_index_;
+    registry.pop_back();
+}
+
+size_t CollectCycles(const Closure& roots) {
+    auto& registry = GetInstanceRegistry();
+
+    // Пометка: обход полей экземпляров, достижимых из корней
+    unordered_set<const ClassInstance*> alive;
+    vector<ClassInstance*> work;
+
+    auto visit = [&](const ObjectHolder& value) {
+        if (auto* instance = value.TryAs<ClassInstance>();
+            instance != nullptr && alive.insert(instance).second) {
+            work.push_back(instance);
+        }
+    };
+
+    for (const auto& [name, value] : roots) {
+        visit(value);
+    }
+
+    while (!work.empty()) {
+        const ClassInstance* instance = work.back();
+        work.pop_back();
+
+        for (const auto& [name, value] : instance->Fields()) {
+            visit(value);
+        }
+    }
+
+    // Недостижимые экземпляры удерживаются на время очистки, чтобы каскадные
+    // освобождения не разрушали их посреди обхода
+    vector<ObjectHolder> doomed;
 
-            return class_method->body->Execute(closure, context);
+    for (ClassInstance* instance : registry) {
+        if (alive.count(instance) == 0) {
+            doomed.emplace_back(ObjectHolder(instance, ObjectHolder::Tag::Data));
         }
     }
 
-    throw std::runtime_error("Method "s + method + " has not found"s);
+    // Разрыв циклов: без полей экземпляры держат друг друга только
+    // через doomed, и уничтожение держателей освобождает их
+    for (auto& holder : doomed) {
+        holder.TryAs<ClassInstance>()->Fields().clear();
+    }
+
+    const size_t collected = doomed.size();
+    doomed.clear();
+    return collected;
+}
+
+Closure& Context::AcquireFrame() {
+    if (frame_depth_ == frames_.size()) {
+        frames_.push_back(make_unique<Closure>());
+    }
+
+    return *frames_[frame_depth_++];
+}
+
+void Context::ReleaseFrame() noexcept {
+    --frame_depth_;
+    frames_[frame_depth_]->clear();
+}
+
+ObjectHolder ClassInstance::Call(Symbol method,
+                                 const ArgList& actual_args,
+                                 Context& context) {
+    const auto* class_method = cls_.GetMethod(method);
+
+    if (!class_method || class_method->param_symbols.size() != actual_args.size()) {
+        throw std::runtime_error("Method "s + method.GetName() + " has not found"s);
+    }
+
+    return CallMethod(class_method, actual_args, context);
+}
+
+ObjectHolder ClassInstance::CallMethod(const Method* method,
+                                       const ArgList& actual_args,
+                                       Context& context) {
+    MYTHON_PROFILE_METHOD(method->name);
+
+    // Кадр вызова занимается в стеке кадров контекста; страж возвращает
+    // его при любом выходе из метода, в том числе по исключению
+    Closure& closure = context.AcquireFrame();
+    FrameGuard guard{context};
+
+    closure.reserve(1 + actual_args.size());
+    closure[SELF_NAME] = ObjectHolder::Share(*this);
+
+    for (size_t i = 0; i < actual_args.size(); ++i) {
+        closure[method->param_symbols[i]] = actual_args[i];
+    }
+
+    return method->body->Execute(closure, context);
 }
 
 Class::Class(std::string name, std::vector<Method> methods, const Class* parent) :
+    Object(Type::Class),
     name_(move(name)),
     methods_(move(methods)),
     parent_(parent) {
-}
+    // Интернируем имена методов и параметров: поиск метода и связывание
+    // аргументов при вызове выполняются сравнением номеров символов
+    for (auto& method : methods_) {
+        method.name_symbol = Symbol(method.name);
+        method.param_symbols.assign(method.formal_params.begin(), method.formal_params.end());
+    }
 
-const Method* Class::GetMethod(const std::string& name) const {
-    auto it = find_if(methods_.begin(), methods_.end(), [&name](const auto& method){
-        return method.name == name;
-    });
+    // Сплющиваем наследование: берём таблицу родителя целиком и
+    // перекрываем её собственными методами. Указатели на методы родителя
+    // остаются валидными - классы не изменяются после создания
+    if (parent_) {
+        method_table_ = parent_->method_table_;
+    }
 
-    if (it != methods_.end()) {
-        return &*it;
+    for (const auto& method : methods_) {
+        method_table_[method.name_symbol] = &method;
     }
+}
 
-    return parent_ ? parent_->GetMethod(name) : nullptr;
+const Method* Class::GetMethod(Symbol name) const {
+    auto it = method_table_.find(name);
+    return it != method_table_.end() ? it->second : nullptr;
 }
 
 [[nodiscard]] const std::string& Class::GetName() const {
@@ -152,8 +647,10 @@ bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
             return left->GetValue() == right->GetValue();
         }
     } else if (auto* instance = lhs.TryAs<ClassInstance>()) {
-        if (instance->HasMethod("__eq__"s, 1U)) {
-            auto res = instance->Call("__eq__"s, {rhs}, context);
+        const auto* method = instance->GetClass().GetMethod(EQ_METHOD);
+
+        if (method && method->param_symbols.size() == 1U) {
+            auto res = instance->CallMethod(method, {rhs}, context);
             return res.TryAs<Bool>()->GetValue();
         }
     }
@@ -179,8 +676,10 @@ bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
             return left->GetValue() < right->GetValue();
         }
     } else if (auto* instance = lhs.TryAs<ClassInstance>()) {
-        if (instance->HasMethod("__lt__"s, 1U)) {
-            auto res = instance->Call("__lt__"s, {rhs}, context);
+        const auto* method = instance->GetClass().GetMethod(LT_METHOD);
+
+        if (method && method->param_symbols.size() == 1U) {
+            auto res = instance->CallMethod(method, {rhs}, context);
             return res.TryAs<Bool>()->GetValue();
         }
     }
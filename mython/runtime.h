@@ -1,43 +1,213 @@
 #pragma once
 
+#include "arena.h"
+#include "profiler.h"
+#include "symbol.h"
+
+#include <charconv>
+#include <functional>
 #include <memory>
+#include <new>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
-namespace runtime {
+namespace vm {
+class Compiler;
+}
 
-// Контекст исполнения инструкций Mython
-class Context {
-public:
-    // Возвращает поток вывода для команд print
-    virtual std::ostream& GetOutputStream() = 0;
+namespace runtime {
 
-protected:
-    ~Context() = default;
-};
+// Контекст исполнения инструкций Mython (определён ниже, после ObjectHolder)
+class Context;
 
 // Базовый класс для всех объектов языка Mython
 class Object {
 public:
+    // Тег типа объекта. Задаётся один раз при конструировании и позволяет
+    // проверять тип сравнением тега вместо dynamic_cast (RTTI заметно дороже).
+    // Other - пользовательские наследники Object, для них остаётся dynamic_cast
+    enum class Type : char {
+        Other,
+        Number,
+        String,
+        Bool,
+        Class,
+        ClassInstance,
+    };
+
     virtual ~Object() = default;
     // выводит в os своё представление в виде строки
     virtual void Print(std::ostream& os, Context& context) = 0;
+
+    // Дописывает своё представление в буфер вывода контекста (Context::Append),
+    // минуя ostream. По умолчанию печатает через Print в промежуточный поток
+    virtual void PrintTo(Context& context);
+
+    [[nodiscard]] Type GetType() const {
+        return type_;
+    }
+
+protected:
+    Object() = default;
+
+    explicit Object(Type type)
+        : type_(type) {
+    }
+
+    // Копия - это новый объект: счётчик ссылок исходного не наследуется
+    Object(const Object& other)
+        : type_(other.type_) {
+    }
+
+    Object& operator=(const Object& /*other*/) {
+        return *this;
+    }
+
+private:
+    friend class ObjectHolder;
+
+    Type type_ = Type::Other;
+    // Интрузивный счётчик ссылок, им управляет ObjectHolder.
+    // Интерпретатор однопоточен в пределах программы - счётчик не атомарный
+    std::uint32_t ref_count_ = 0;
+};
+
+// Объект-значение, хранящий значение типа T
+template <typename T>
+class ValueObject : public Object {
+public:
+    ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+        : Object(TypeFor()),
+          value_(std::move(v)) {
+    }
+
+    void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
+        os << value_;
+    }
+
+    void PrintTo(Context& context) override;
+
+    [[nodiscard]] const T& GetValue() const {
+        return value_;
+    }
+
+private:
+    static constexpr Type TypeFor() {
+        if constexpr (std::is_same_v<T, int>) {
+            return Type::Number;
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return Type::String;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return Type::Bool;
+        } else {
+            return Type::Other;
+        }
+    }
+
+    T value_;
 };
 
-// Специальный класс-обёртка, предназначенный для хранения объекта в Mython-программе
+// Строковое значение с ленивой конкатенацией; определено после ObjectHolder
+class String;
+// Числовое значение
+using Number = ValueObject<int>;
+
+// Логическое значение
+class Bool : public ValueObject<bool> {
+public:
+    using ValueObject<bool>::ValueObject;
+
+    void Print(std::ostream& os, Context& context) override;
+};
+
+class Class;
+class ClassInstance;
+class Closure;
+
+// Объявлен ниже; друг ObjectHolder - ему нужно удерживать объекты,
+// найденные в реестре экземпляров, на время очистки циклов
+std::size_t CollectCycles(const Closure& roots);
+
+namespace detail {
+
+// Тег типа, соответствующий классу-наследнику Object,
+// либо Type::Other, если тип проверяется через dynamic_cast
+template <typename T>
+constexpr Object::Type TypeTagFor() {
+    if constexpr (std::is_same_v<T, Number>) {
+        return Object::Type::Number;
+    } else if constexpr (std::is_same_v<T, String>) {
+        return Object::Type::String;
+    } else if constexpr (std::is_same_v<T, Bool>) {
+        return Object::Type::Bool;
+    } else if constexpr (std::is_same_v<T, Class>) {
+        return Object::Type::Class;
+    } else if constexpr (std::is_same_v<T, ClassInstance>) {
+        return Object::Type::ClassInstance;
+    } else {
+        return Object::Type::Other;
+    }
+}
+
+// Подпись категории аллокаций типа T для отчётов профилировщика
+template <typename T>
+constexpr const char* AllocLabelFor() {
+    if constexpr (std::is_same_v<T, Number>) {
+        return "alloc Number";
+    } else if constexpr (std::is_same_v<T, String>) {
+        return "alloc String";
+    } else if constexpr (std::is_same_v<T, Bool>) {
+        return "alloc Bool";
+    } else if constexpr (std::is_same_v<T, Class>) {
+        return "alloc Class";
+    } else if constexpr (std::is_same_v<T, ClassInstance>) {
+        return "alloc ClassInstance";
+    } else {
+        return "alloc Object";
+    }
+}
+
+}  // namespace detail
+
+/*
+ * Специальный класс-обёртка, предназначенный для хранения объекта в Mython-программе.
+ *
+ * Значения-числа и логические значения хранятся прямо внутри обёртки
+ * и не требуют выделения памяти в куче: каждый результат арифметической
+ * операции или сравнения - это просто копирование нескольких байт.
+ * Строки и экземпляры классов, как и раньше, живут в куче и разделяются
+ * между обёртками
+ */
 class ObjectHolder {
 public:
     // Создаёт пустое значение
     ObjectHolder() = default;
 
+    ObjectHolder(const ObjectHolder& other);
+    ObjectHolder(ObjectHolder&& other) noexcept;
+    ObjectHolder& operator=(const ObjectHolder& other);
+    ObjectHolder& operator=(ObjectHolder&& other) noexcept;
+    ~ObjectHolder();
+
     // Возвращает ObjectHolder, владеющий объектом типа T
     // Тип T - конкретный класс-наследник Object.
-    // object копируется или перемещается в кучу
+    // Числа и Bool размещаются внутри обёртки, остальные объекты - в куче
     template <typename T>
     [[nodiscard]] static ObjectHolder Own(T&& object) {
-        return ObjectHolder(std::make_shared<T>(std::forward<T>(object)));
+        using Value = std::decay_t<T>;
+
+        MYTHON_PROFILE_COUNT(detail::AllocLabelFor<Value>());
+
+        if constexpr (std::is_same_v<Value, Number> || std::is_same_v<Value, Bool>) {
+            ObjectHolder result;
+            result.PlaceInline(std::forward<T>(object));
+            return result;
+        } else {
+            return ObjectHolder(new Value(std::forward<T>(object)), Tag::Data);
+        }
     }
 
     // Создаёт ObjectHolder, не владеющий объектом (аналог слабой ссылки)
@@ -57,41 +227,346 @@ public:
     // объект данного типа
     template <typename T>
     [[nodiscard]] T* TryAs() const {
-        return dynamic_cast<T*>(this->Get());
+        auto* object = this->Get();
+
+        if constexpr (constexpr auto tag = detail::TypeTagFor<T>(); tag != Object::Type::Other) {
+            return object != nullptr && object->GetType() == tag ? static_cast<T*>(object)
+                                                                 : nullptr;
+        } else {
+            return dynamic_cast<T*>(object);
+        }
     }
 
     // Возвращает true, если ObjectHolder не пуст
     explicit operator bool() const;
 
 private:
-    explicit ObjectHolder(std::shared_ptr<Object> data);
+    friend std::size_t runtime::CollectCycles(const Closure& roots);
+
+    // Тип значения внутри обёртки. Data - объект в куче под интрузивным
+    // счётчиком ссылок либо None (нулевой указатель), Borrowed - невладеющая
+    // ссылка на чужой объект (счётчик не трогается)
+    enum class Tag : char {
+        Data,
+        Borrowed,
+        InlineNumber,
+        InlineBool,
+    };
+
+    ObjectHolder(Object* data, Tag tag);
     void AssertIsValid() const;
 
-    std::shared_ptr<Object> data_;
+    void PlaceInline(Number number);
+    void PlaceInline(Bool value);
+    // Возвращает указатель на объект во встроенном хранилище
+    [[nodiscard]] Object* GetInline() const;
+    // Приводит обёртку к пустому состоянию, разрушая встроенный объект
+    void Reset();
+    void CopyFrom(const ObjectHolder& other);
+    void MoveFrom(ObjectHolder&& other) noexcept;
+
+    Tag tag_ = Tag::Data;
+    Object* data_ = nullptr;
+    // Встроенное хранилище для Number и Bool
+    mutable std::aligned_union_t<0, Number, Bool> inline_storage_;
+};
+
+/*
+ * Строковое значение с представлением-«верёвкой»: конкатенация за O(1)
+ * создаёт узел, разделяющий обе части, без копирования байтов. Сплошное
+ * представление строится лениво при первом обращении к GetValue (печать,
+ * сравнение, приведение к строке) и запоминается. Короткие результаты
+ * склеиваются сразу - их хранит std::string со встроенным буфером
+ */
+class String : public Object {
+public:
+    String(std::string v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+        : Object(Type::String),
+          value_(std::move(v)),
+          size_(value_.size()) {
+    }
+
+    void Print(std::ostream& os, Context& context) override;
+    void PrintTo(Context& context) override;
+
+    // Сплошное представление; у верёвки строится и запоминается при первом вызове
+    [[nodiscard]] const std::string& GetValue() const;
+
+    // Длина строки; известна без выпрямления верёвки
+    [[nodiscard]] std::size_t Size() const {
+        return size_;
+    }
+
+    /*
+     * O(1)-конкатенация: узел разделяет держатели частей, байты не копируются.
+     * Оба аргумента должны содержать String. Заимствованные (Share) держатели
+     * остаются заимствованными - такие части должны пережить результат
+     */
+    [[nodiscard]] static ObjectHolder Concat(const ObjectHolder& lhs, const ObjectHolder& rhs);
+
+private:
+    // До этой суммарной длины части склеиваются сразу
+    static constexpr std::size_t SMALL_CONCAT = 64;
+
+    String(ObjectHolder lhs, ObjectHolder rhs, std::size_t size);
+
+    void Flatten() const;
+
+    // Сплошные байты (актуальны, когда части пусты) и ленивые части верёвки
+    mutable std::string value_;
+    mutable ObjectHolder lhs_;
+    mutable ObjectHolder rhs_;
+    std::size_t size_ = 0;
+};
+
+// Контекст исполнения инструкций Mython
+class Context {
+public:
+    // Возвращает поток вывода для команд print
+    virtual std::ostream& GetOutputStream() = 0;
+
+    // Буферизованный вывод: команда print дописывает значения в символьный
+    // буфер и одним Flush сбрасывает его в GetOutputStream(), не платя
+    // за sentry и локали ostream на каждое значение
+    void Append(std::string_view text) {
+        out_buffer_.append(text);
+    }
+
+    void Append(char c) {
+        out_buffer_.push_back(c);
+    }
+
+    // Числа форматируются напрямую через to_chars
+    void Append(int value) {
+        char digits[16];
+        const auto [last, ec] = std::to_chars(std::begin(digits), std::end(digits), value);
+        out_buffer_.append(digits, last);
+    }
+
+    void Append(bool value) {
+        Append(value ? std::string_view("True") : std::string_view("False"));
+    }
+
+    void Append(const std::string& text) {
+        out_buffer_.append(text);
+    }
+
+    // Строковые литералы не должны попадать в перегрузку для bool
+    void Append(const char* text) {
+        out_buffer_.append(text);
+    }
+
+    // Сбрасывает накопленный буфер вывода через Deliver
+    void Flush() {
+        if (!out_buffer_.empty()) {
+            Deliver(std::move(out_buffer_));
+            out_buffer_.clear();
+        }
+    }
+
+    // Возвращает строковое представление object, напечатанное через PrintTo.
+    // Текущее содержимое буфера вывода не затрагивается
+    std::string Represent(Object& object);
+
+    // Отмечает, что выполняется возврат из метода со значением value.
+    // Инструкция return устанавливает флаг, объемлющие инструкции прекращают
+    // выполнение, а MethodBody снимает флаг и возвращает значение - выход
+    // из метода обходится проверкой флага, без исключений
+    void SignalReturn(ObjectHolder value) {
+        returning_ = true;
+        return_value_ = std::move(value);
+    }
+
+    // Возвращает true, если выполняется возврат из метода
+    [[nodiscard]] bool IsReturning() const {
+        return returning_;
+    }
+
+    // Снимает флаг возврата и возвращает возвращаемое значение
+    ObjectHolder TakeReturnValue() {
+        returning_ = false;
+        return std::move(return_value_);
+    }
+
+    // Стек кадров вызова: CallMethod занимает кадр на глубине текущего
+    // вызова и возвращает его при выходе. Кадр переиспользуется вместе
+    // с накопленной ёмкостью - резервирование слотов при повторных
+    // вызовах той же глубины обходится без выделения памяти
+    Closure& AcquireFrame();
+    void ReleaseFrame() noexcept;
+
+protected:
+    ~Context() = default;
+
+private:
+    // Доставляет готовый фрагмент вывода. По умолчанию - блокирующая
+    // запись в GetOutputStream(); SinkContext передаёт фрагмент приёмнику
+    virtual void Deliver(std::string&& chunk) {
+        GetOutputStream().write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+
+    bool returning_ = false;
+    ObjectHolder return_value_;
+    std::string out_buffer_;
+    // Кадры хранятся по глубине вызова; косвенность нужна, чтобы ссылки
+    // на внешние кадры переживали рост стека
+    std::vector<std::unique_ptr<Closure>> frames_;
+    std::size_t frame_depth_ = 0;
 };
 
-// Объект-значение, хранящий значение типа T
 template <typename T>
-class ValueObject : public Object {
+void ValueObject<T>::PrintTo(Context& context) {
+    context.Append(GetValue());
+}
+
+/*
+ * Таблица символов, связывающая имя объекта с его значением.
+ *
+ * Подавляющее большинство таблиц - кадры вызова метода (self плюс несколько
+ * параметров и локальных имён), поэтому записи хранятся плоским массивом:
+ * создание кадра - одно выделение памяти, а поиск имени - просмотр слотов
+ * сравнением номеров символов, без хеширования. Для редких больших таблиц
+ * (глобальное окружение длинного скрипта) поверх массива строится хеш-индекс.
+ *
+ * Интерфейс повторяет использовавшийся ранее std::unordered_map
+ */
+class Closure {
 public:
-    ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
-        : value_(v) {
+    using value_type = std::pair<Symbol, ObjectHolder>;
+    using storage = std::vector<value_type>;
+    using iterator = storage::iterator;
+    using const_iterator = storage::const_iterator;
+
+    static constexpr std::size_t NPOS = static_cast<std::size_t>(-1);
+
+    Closure() = default;
+    Closure(std::initializer_list<value_type> items);
+
+    // Возвращает значение имени name, создавая пустой слот при его отсутствии
+    ObjectHolder& operator[](Symbol name);
+
+    // Возвращает номер слота имени name либо NPOS. Вместе со Slot позволяет
+    // кэшировать позицию поля: у экземпляров одного класса поля занимают
+    // одинаковые слоты (общая «форма»), пока класс задаёт их в одном порядке
+    [[nodiscard]] std::size_t FindSlot(Symbol name) const {
+        return FindPos(name);
     }
 
-    void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
-        os << value_;
+    // Прямой доступ к слоту по номеру, pos < size()
+    value_type& Slot(std::size_t pos) {
+        return items_[pos];
     }
 
-    [[nodiscard]] const T& GetValue() const {
-        return value_;
+    ObjectHolder& at(Symbol name);
+    [[nodiscard]] const ObjectHolder& at(Symbol name) const;
+
+    [[nodiscard]] std::size_t count(Symbol name) const;
+
+    iterator find(Symbol name);
+    [[nodiscard]] const_iterator find(Symbol name) const;
+
+    std::pair<iterator, bool> insert(value_type item);
+
+    // Резервирует место под кадр известного размера
+    void reserve(std::size_t capacity) {
+        items_.reserve(capacity);
+    }
+
+    iterator begin() {
+        return items_.begin();
+    }
+    iterator end() {
+        return items_.end();
+    }
+    [[nodiscard]] const_iterator begin() const {
+        return items_.begin();
+    }
+    [[nodiscard]] const_iterator end() const {
+        return items_.end();
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return items_.size();
+    }
+    [[nodiscard]] bool empty() const {
+        return items_.empty();
     }
+    void clear();
 
 private:
-    T value_;
+    // Начиная с этого размера таблица обзаводится хеш-индексом
+    static constexpr std::size_t INDEX_THRESHOLD = 16;
+
+    [[nodiscard]] std::size_t FindPos(Symbol name) const;
+    ObjectHolder& Append(Symbol name, ObjectHolder value);
+
+    storage items_;
+    std::unordered_map<Symbol, std::size_t> index_;
+    bool indexed_ = false;
 };
 
-// Таблица символов, связывающая имя объекта с его значением
-using Closure = std::unordered_map<std::string, ObjectHolder>;
+// Аргументы вызова метода. До INLINE_CAPACITY значений живут во встроенном
+// буфере - типичные вызовы с одним-двумя аргументами не обращаются к куче.
+// Слоты буфера конструируются только по мере заполнения, поэтому пустой
+// список (вызов без аргументов) не стоит практически ничего
+class ArgList {
+public:
+    static constexpr std::size_t INLINE_CAPACITY = 4;
+
+    ArgList() = default;
+
+    ArgList(std::initializer_list<ObjectHolder> items) {
+        for (const auto& item : items) {
+            push_back(item);
+        }
+    }
+
+    ArgList(const ArgList&) = delete;
+    ArgList& operator=(const ArgList&) = delete;
+
+    ~ArgList() {
+        const std::size_t inline_count = size_ < INLINE_CAPACITY ? size_ : INLINE_CAPACITY;
+
+        for (std::size_t i = 0; i < inline_count; ++i) {
+            SlotAt(i)->~ObjectHolder();
+        }
+    }
+
+    void push_back(ObjectHolder value) {
+        if (size_ < INLINE_CAPACITY) {
+            new (&inline_[size_]) ObjectHolder(std::move(value));
+        } else {
+            overflow_.push_back(std::move(value));
+        }
+
+        ++size_;
+    }
+
+    [[nodiscard]] const ObjectHolder& operator[](std::size_t index) const {
+        return index < INLINE_CAPACITY ? *SlotAt(index) : overflow_[index - INLINE_CAPACITY];
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return size_;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return size_ == 0;
+    }
+
+private:
+    [[nodiscard]] const ObjectHolder* SlotAt(std::size_t index) const {
+        return reinterpret_cast<const ObjectHolder*>(&inline_[index]);
+    }
+
+    ObjectHolder* SlotAt(std::size_t index) {
+        return reinterpret_cast<ObjectHolder*>(&inline_[index]);
+    }
+
+    std::aligned_storage_t<sizeof(ObjectHolder), alignof(ObjectHolder)> inline_[INLINE_CAPACITY];
+    std::vector<ObjectHolder> overflow_;
+    std::size_t size_ = 0;
+};
 
 // Проверяет, содержится ли в object значение, приводимое к True
 // Для отличных от нуля чисел, True и непустых строк возвращается true. В остальных случаях - false.
@@ -104,19 +579,43 @@ public:
     // Выполняет действие над объектами внутри closure, используя context
     // Возвращает результирующее значение либо None
     virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
-};
 
-// Строковое значение
-using String = ValueObject<std::string>;
-// Числовое значение
-using Number = ValueObject<int>;
+    // Вычисляет узел как условие. Эквивалентно IsTrue(Execute(...)), но
+    // сравнения и логические связки переопределяют метод и возвращают
+    // результат без упаковки в Bool
+    virtual bool ExecuteCondition(Closure& closure, Context& context) {
+        return IsTrue(Execute(closure, context));
+    }
 
-// Логическое значение
-class Bool : public ValueObject<bool> {
-public:
-    using ValueObject<bool>::ValueObject;
+    // Транслирует инструкцию в байт-код виртуальной машины (см. vm.h).
+    // Возвращает false, если инструкция не поддерживает компиляцию, -
+    // тогда она выполняется обходом дерева через Execute
+    virtual bool Compile(vm::Compiler& /*compiler*/) {
+        return false;
+    }
 
-    void Print(std::ostream& os, Context& context) override;
+    // Возвращает true для узлов-констант, которые вычисляются
+    // без обращения к окружению и контексту
+    [[nodiscard]] virtual bool IsConstant() const {
+        return false;
+    }
+
+    // Упрощает поддерево узла (см. ast::Fold): переопределения сворачивают
+    // дочерние узлы и возвращают замену самого узла либо nullptr,
+    // если узел остаётся на месте
+    virtual std::unique_ptr<Executable> Fold() {
+        return nullptr;
+    }
+
+    // Узлы программ выделяются из пула (см. arena.h): их создают и разрушают
+    // тысячами при разборе скриптов, и пул избавляет от обращений к куче
+    static void* operator new(std::size_t size) {
+        return arena::NodePool::Allocate(size);
+    }
+
+    static void operator delete(void* ptr, std::size_t size) noexcept {
+        arena::NodePool::Deallocate(ptr, size);
+    }
 };
 
 // Метод класса
@@ -127,6 +626,11 @@ struct Method {
     std::vector<std::string> formal_params;
     // Тело метода
     std::unique_ptr<Executable> body;
+
+    // Интернированные имя метода и имена параметров.
+    // Заполняются конструктором Class, задавать их вручную не нужно
+    Symbol name_symbol = {};
+    std::vector<Symbol> param_symbols = {};
 };
 
 // Класс
@@ -136,8 +640,9 @@ public:
     // Если parent равен nullptr, то создаётся базовый класс
     explicit Class(std::string name, std::vector<Method> methods, const Class* parent);
 
-    // Возвращает указатель на метод name или nullptr, если метод с таким именем отсутствует
-    [[nodiscard]] const Method* GetMethod(const std::string& name) const;
+    // Возвращает указатель на метод name или nullptr, если метод с таким именем отсутствует.
+    // Поиск - одно обращение к таблице методов, без обхода цепочки наследования
+    [[nodiscard]] const Method* GetMethod(Symbol name) const;
 
     // Возвращает имя класса
     [[nodiscard]] const std::string& GetName() const;
@@ -149,6 +654,9 @@ private:
     std::string name_;
     std::vector<Method> methods_;
     const Class* parent_;
+    // Сплющенная таблица методов: собственные методы плюс унаследованные.
+    // Строится один раз в конструкторе - классы после создания неизменяемы
+    std::unordered_map<Symbol, const Method*> method_table_;
 };
 
 // Экземпляр класса
@@ -156,23 +664,42 @@ class ClassInstance : public Object {
 public:
     explicit ClassInstance(const Class& cls);
 
+    // Каждый построенный экземпляр (включая копии) занимает свой слот
+    // в потоковом реестре для сборщика циклов и освобождает его в деструкторе
+    ClassInstance(const ClassInstance& other);
+    ClassInstance(ClassInstance&& other) noexcept;
+    ~ClassInstance() override;
+
     /*
      * Если у объекта есть метод __str__, выводит в os результат, возвращённый этим методом.
      * В противном случае в os выводится адрес объекта.
      */
     void Print(std::ostream& os, Context& context) override;
 
+    // То же представление, но в буфер вывода контекста
+    void PrintTo(Context& context) override;
+
     /*
      * Вызывает у объекта метод method, передавая ему actual_args параметров.
      * Параметр context задаёт контекст для выполнения метода.
      * Если ни сам класс, ни его родители не содержат метод method, метод выбрасывает исключение
      * runtime_error
      */
-    ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& actual_args,
-                      Context& context);
+    ObjectHolder Call(Symbol method, const ArgList& actual_args, Context& context);
+
+    // Вызывает уже найденный метод класса, минуя поиск по имени.
+    // method должен принадлежать классу объекта, а число аргументов - совпадать
+    // с числом формальных параметров
+    ObjectHolder CallMethod(const Method* method, const ArgList& actual_args,
+                            Context& context);
 
     // Возвращает true, если объект имеет метод method, принимающий argument_count параметров
-    [[nodiscard]] bool HasMethod(const std::string& method, size_t argument_count) const;
+    [[nodiscard]] bool HasMethod(Symbol method, size_t argument_count) const;
+
+    // Возвращает класс объекта
+    [[nodiscard]] const Class& GetClass() const {
+        return cls_;
+    }
 
     // Возвращает ссылку на Closure, содержащий поля объекта
     [[nodiscard]] Closure& Fields();
@@ -182,8 +709,87 @@ public:
 private:
     const Class& cls_;
     Closure fields_;
+    void Register();
+
+    // Позиция в реестре экземпляров потока (см. CollectCycles)
+    std::size_t registry_index_ = 0;
+};
+
+/*
+ * Кэш позиции поля в конкретной точке обращения a.b или a.b = ...
+ *
+ * Экземпляры одного класса обычно получают поля в одном и том же порядке
+ * (из __init__), поэтому поле с данным именем занимает один и тот же слот -
+ * общую «форму». Пока класс объекта в точке обращения не меняется, поле
+ * читается по запомненному номеру слота без поиска по имени; совпадение
+ * имени в слоте проверяется на случай разошедшихся форм
+ */
+struct FieldSite {
+    Symbol name;
+    const Class* cls = nullptr;
+    std::size_t slot = Closure::NPOS;
+};
+
+// Возвращает слот поля site.name в instance, обновляя кэш site.
+// Отсутствующее поле, как и в Closure::operator[], создаётся со значением None.
+// Использовать только на пути записи (object.field = ...)
+ObjectHolder& ResolveField(ClassInstance& instance, FieldSite& site);
+
+// То же для чтения: отсутствующее поле не создаётся - чтение не должно
+// молча наращивать таблицы полей экземпляров. Возвращает nullptr при промахе
+ObjectHolder* FindField(ClassInstance& instance, FieldSite& site);
+
+/*
+ * Кэш позиции имени в точке обращения к переменной.
+ *
+ * Кадры повторных вызовов одного метода (и глобальное замыкание программы)
+ * раскладывают имена по одним и тем же слотам, поэтому, как и в FieldSite,
+ * достаточно запомнить номер слота и сверять имя в нём при каждом обращении
+ */
+struct NameSite {
+    Symbol name;
+    std::size_t slot = Closure::NPOS;
 };
 
+// Возвращает значение имени site.name в closure либо nullptr, обновляя кэш site
+ObjectHolder* ResolveName(Closure& closure, NameSite& site);
+
+/*
+ * Сборщик циклов. Подсчёт ссылок не освобождает взаимно ссылающиеся
+ * экземпляры (self.other = peer; peer.other = self) - такие пары переживают
+ * свою программу и накапливаются в долгоживущем интерпретаторе.
+ *
+ * Обходит замыкание roots и поля достижимых из него экземпляров; экземпляры
+ * текущего потока, не достижимые из корней, удерживаются только циклами.
+ * Их поля очищаются, после чего обычный подсчёт ссылок освобождает объекты.
+ * Вызывать между выполнениями программ, когда на объекты не ссылаются
+ * временные ObjectHolder на стеке C++. Возвращает число собранных экземпляров
+ */
+std::size_t CollectCycles(const Closure& roots);
+
+/*
+ * Фабрики канонических значений - единственный способ создания чисел,
+ * логических значений и строк в statement.cpp и vm.cpp.
+ *
+ * Числа и логические значения размещаются во встроенном хранилище
+ * ObjectHolder (см. выше) и кучу не трогают вовсе, поэтому отдельный кэш
+ * малых чисел и синглтоны True/False не нужны: результат арифметики или
+ * сравнения - копирование нескольких байт. Строковые литералы программ
+ * разделяются через ValueStatement, в кучу попадают только строки,
+ * построенные во время выполнения
+ */
+inline ObjectHolder MakeNumber(int value) {
+    return ObjectHolder::Own(Number(value));
+}
+
+inline ObjectHolder MakeBool(bool value) {
+    return ObjectHolder::Own(Bool(value));
+}
+
+inline ObjectHolder MakeString(std::string value) {
+    return ObjectHolder::Own(String(std::move(value)));
+}
+
 /*
  * Возвращает true, если lhs и rhs содержат одинаковые числа, строки или значения типа Bool.
  * Если lhs - объект с методом __eq__, функция возвращает результат вызова lhs.__eq__(rhs),
@@ -237,4 +843,44 @@ private:
     std::ostream& output_;
 };
 
+/*
+ * Контекст для встраивания интерпретатора в асинхронное окружение.
+ *
+ * Каждый Flush передаёт готовый фрагмент вывода приёмнику целиком, и
+ * интерпретатор продолжает работу, не дожидаясь записи, - доставкой
+ * (сокет, очередь событий) занимается владелец приёмника в своём темпе.
+ * Фрагменты приходят в порядке команд print; приёмник вызывается из потока
+ * интерпретатора, поэтому ограничение очереди (back-pressure) приёмник
+ * реализует сам - например, блокируясь при переполнении.
+ *
+ * Вывод мимо буфера - напрямую в GetOutputStream() - накапливается
+ * во внутреннем потоке и уходит в приёмник перед фрагментом
+ * очередного Flush
+ */
+class SinkContext : public Context {
+public:
+    using Sink = std::function<void(std::string&&)>;
+
+    explicit SinkContext(Sink sink)
+        : sink_(std::move(sink)) {
+    }
+
+    std::ostream& GetOutputStream() override {
+        return direct_;
+    }
+
+private:
+    void Deliver(std::string&& chunk) override {
+        if (auto direct = direct_.str(); !direct.empty()) {
+            direct_.str({});
+            sink_(std::move(direct));
+        }
+
+        sink_(std::move(chunk));
+    }
+
+    Sink sink_;
+    std::ostringstream direct_;
+};
+
 }  // namespace runtime
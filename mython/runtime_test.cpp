@@ -19,7 +19,8 @@ public:
     }
 
     Logger(const Logger& rhs)
-        : id_(rhs.id_)  //
+        : Object(rhs),
+          id_(rhs.id_)  //
     {
         ++instance_count;
     }
@@ -529,6 +530,103 @@ void TestClassInstance() {
     ASSERT_THROWS(instance.Call("missing_method"s, {}, ctx), runtime_error);
 }
 
+void TestSinkContext() {
+    vector<string> chunks;
+    SinkContext context([&chunks](string&& chunk) { chunks.push_back(move(chunk)); });
+
+    context.Append("value = "s);
+    context.Append(42);
+    context.Append('\n');
+    context.Flush();
+
+    context.Append(true);
+    context.Flush();
+
+    // Пустой буфер не порождает фрагмента
+    context.Flush();
+
+    ASSERT_EQUAL(chunks.size(), 2U);
+    ASSERT_EQUAL(chunks[0], "value = 42\n"s);
+    ASSERT_EQUAL(chunks[1], "True"s);
+
+    // Вывод напрямую в поток уходит в приёмник перед очередным фрагментом
+    context.GetOutputStream() << "direct"s;
+    context.Append("buffered"s);
+    context.Flush();
+
+    ASSERT_EQUAL(chunks.size(), 4U);
+    ASSERT_EQUAL(chunks[2], "direct"s);
+    ASSERT_EQUAL(chunks[3], "buffered"s);
+}
+
+void TestFieldLookup() {
+    Class cls{"Test"s, {}, nullptr};
+    ClassInstance instance{cls};
+
+    instance.Fields()["x"s] = ObjectHolder::Own(Number{42});
+
+    FieldSite hit{"x"s, nullptr, Closure::NPOS};
+    auto* field = FindField(instance, hit);
+    ASSERT(field != nullptr);
+    ASSERT_EQUAL(field->TryAs<Number>()->GetValue(), 42);
+
+    // Повторное обращение идёт по закэшированному слоту
+    ASSERT_EQUAL(FindField(instance, hit), field);
+
+    // Промах чтения не создаёт слот в таблице полей
+    FieldSite miss{"y"s, nullptr, Closure::NPOS};
+    ASSERT(FindField(instance, miss) == nullptr);
+    ASSERT_EQUAL(instance.Fields().size(), 1U);
+
+    // Путь записи, напротив, создаёт поле со значением None
+    ResolveField(instance, miss) = ObjectHolder::Own(Number{1});
+    ASSERT_EQUAL(instance.Fields().size(), 2U);
+}
+
+void TestStringConcat() {
+    auto a = MakeString("Hello, "s);
+    auto b = MakeString("world"s);
+
+    // Короткий результат склеивается сразу
+    auto ab = String::Concat(a, b);
+    ASSERT_EQUAL(ab.TryAs<String>()->GetValue(), "Hello, world"s);
+
+    // Длинная цепочка: узлы верёвки, выпрямление один раз при чтении
+    auto rope = MakeString(string(40, 'x'));
+    string expected(40, 'x');
+
+    for (int i = 0; i < 10; ++i) {
+        rope = String::Concat(rope, rope);
+        expected += expected;
+    }
+
+    ASSERT_EQUAL(rope.TryAs<String>()->Size(), expected.size());
+    ASSERT_EQUAL(rope.TryAs<String>()->GetValue(), expected);
+
+    DummyContext ctx;
+    ASSERT(Equal(rope, MakeString(expected), ctx));
+}
+
+void TestCycleCollection() {
+    Class cls{"Node"s, {}, nullptr};
+    Closure roots;
+
+    {
+        auto a = ObjectHolder::Own(ClassInstance{cls});
+        auto b = ObjectHolder::Own(ClassInstance{cls});
+        a.TryAs<ClassInstance>()->Fields()["other"s] = b;
+        b.TryAs<ClassInstance>()->Fields()["other"s] = a;
+
+        // Пока пара достижима из корней, сборщик её не трогает
+        roots["kept"s] = a;
+        ASSERT_EQUAL(CollectCycles(roots), 0U);
+        roots.clear();
+    }
+
+    // Держатели разрушены, пара удерживает сама себя циклом
+    ASSERT_EQUAL(CollectCycles(roots), 2U);
+}
+
 }  // namespace
 
 void RunObjectsTests(TestRunner& tr) {
@@ -540,6 +638,10 @@ void RunObjectsTests(TestRunner& tr) {
     RUN_TEST(tr, runtime::TestComparison);
     RUN_TEST(tr, runtime::TestClass);
     RUN_TEST(tr, runtime::TestClassInstance);
+    RUN_TEST(tr, runtime::TestSinkContext);
+    RUN_TEST(tr, runtime::TestFieldLookup);
+    RUN_TEST(tr, runtime::TestStringConcat);
+    RUN_TEST(tr, runtime::TestCycleCollection);
 }
 
 void RunObjectHolderTests(TestRunner& tr) {
@@ -1,5 +1,8 @@
 #include "statement.h"
+
+#include "profiler.h"
 #include "runtime.h"
+#include "vm.h"
 
 #include <cstdio>
 #include <iostream>
@@ -17,38 +20,102 @@ using runtime::Context;
 using runtime::ObjectHolder;
 
 namespace {
-const string ADD_METHOD = "__add__"s;
-const string INIT_METHOD = "__init__"s;
+const runtime::Symbol ADD_METHOD = "__add__"s;
+const runtime::Symbol INIT_METHOD = "__init__"s;
+
+// Вычисляет узел с константными операндами и упаковывает результат обратно
+// в узел-константу. Возвращает nullptr, если вычисление не удалось
+// (например, константное деление на ноль) - тогда узел остаётся как есть,
+// а ошибка проявится во время выполнения
+unique_ptr<Statement> EvaluateConstant(Statement& node) {
+    runtime::Closure closure;
+    runtime::DummyContext context;
+
+    try {
+        auto value = node.Execute(closure, context);
+
+        if (!value) {
+            return make_unique<None>();
+        }
+        if (const auto* number = value.TryAs<runtime::Number>()) {
+            return make_unique<NumericConst>(*number);
+        }
+        if (const auto* str = value.TryAs<runtime::String>()) {
+            return make_unique<StringConst>(*str);
+        }
+        if (const auto* boolean = value.TryAs<runtime::Bool>()) {
+            return make_unique<BoolConst>(*boolean);
+        }
+    } catch (...) {
+    }
+
+    return nullptr;
+}
 }  // namespace
 
+unique_ptr<Statement> Fold(unique_ptr<Statement> node) {
+    if (node) {
+        if (auto folded = node->Fold()) {
+            return folded;
+        }
+    }
+
+    return node;
+}
+
 ObjectHolder Assignment::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::Assignment");
     return closure[var_] = rv_->Execute(closure, context);
 }
 
-Assignment::Assignment(std::string var, std::unique_ptr<Statement> rv) :
-    var_(move(var)),
+Assignment::Assignment(runtime::Symbol var, std::unique_ptr<Statement> rv) :
+    var_(var),
     rv_(move(rv)) {
 }
 
+VariableValue::VariableValue(runtime::Symbol var_name) :
+    dotted_ids_({var_name}),
+    name_site_{var_name, runtime::Closure::NPOS} {
+}
+
 VariableValue::VariableValue(const std::string& var_name) :
-    dotted_ids_({var_name}) {
+    VariableValue(runtime::Symbol(var_name)) {
 }
 
-VariableValue::VariableValue(std::vector<std::string> dotted_ids) :
-    dotted_ids_(move(dotted_ids)) {
+VariableValue::VariableValue(std::vector<runtime::Symbol> dotted_ids) :
+    dotted_ids_(move(dotted_ids)),
+    name_site_{dotted_ids_.front(), runtime::Closure::NPOS} {
+    for (size_t i = 1; i < dotted_ids_.size(); ++i) {
+        field_sites_.push_back({dotted_ids_[i], nullptr, runtime::Closure::NPOS});
+    }
 }
 
-ObjectHolder VariableValue::Execute(Closure& closure, Context& /*context*/) {
-    auto object = GetVarByName(closure, dotted_ids_.front());
-    return GetVarByNameRange(dotted_ids_.begin() + 1, dotted_ids_.end(), object);
+VariableValue::VariableValue(const std::vector<std::string>& dotted_ids) :
+    VariableValue(std::vector<runtime::Symbol>(dotted_ids.begin(), dotted_ids.end())) {
 }
 
-runtime::ObjectHolder VariableValue::GetVarByName(runtime::Closure& closure, const string& name) {
-    if (closure.count(name) == 0) {
-        throw runtime_error("Name " + name + " is not defined"s);
+ObjectHolder VariableValue::Execute(Closure& closure, Context& /*context*/) {
+    MYTHON_PROFILE_SCOPE("ast::VariableValue");
+    auto* value = runtime::ResolveName(closure, name_site_);
+
+    if (!value) {
+        throw runtime_error("Name " + name_site_.name.GetName() + " is not defined"s);
+    }
+
+    auto object = *value;
+
+    for (auto& site : field_sites_) {
+        auto* instance = object.TryAs<runtime::ClassInstance>();
+        auto* field = runtime::FindField(*instance, site);
+
+        if (!field) {
+            throw runtime_error("Field " + site.name.GetName() + " is not defined"s);
+        }
+
+        object = *field;
     }
 
-    return closure[name];
+    return object;
 }
 
 unique_ptr<Print> Print::Variable(const std::string& name) {
@@ -64,64 +131,81 @@ Print::Print(vector<unique_ptr<Statement>> args) :
 }
 
 ObjectHolder Print::Execute(Closure& closure, Context& context) {
-    auto& os = context.GetOutputStream();
+    MYTHON_PROFILE_SCOPE("ast::Print");
     bool is_first = true;
 
     for (auto& arg : args_) {
         if (!is_first) {
-            os << ' ';
+            context.Append(' ');
         }
         is_first = false;
 
         if (auto object = arg->Execute(closure, context)) {
-            object->Print(os, context);
+            object->PrintTo(context);
         } else {
-            os << "None"s;
+            context.Append("None"sv);
         }
     }
 
-    os << endl;
+    context.Append('\n');
+    context.Flush();
 
     return ObjectHolder::None();
 }
 
-MethodCall::MethodCall(std::unique_ptr<Statement> object, std::string method,
+MethodCall::MethodCall(std::unique_ptr<Statement> object, runtime::Symbol method,
                        std::vector<std::unique_ptr<Statement>> args) :
     object_(move(object)),
-    method_(move(method)),
+    method_(method),
     args_(move(args)) {
 }
 
 ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
-    vector<ObjectHolder> arguments;
-    arguments.reserve(args_.size());
+    MYTHON_PROFILE_SCOPE("ast::MethodCall");
+    runtime::ArgList arguments;
 
     for (auto& arg : args_) {
         arguments.push_back(arg->Execute(closure, context));
     }
 
-    return object_->Execute(closure, context).TryAs<runtime::ClassInstance>()->Call(method_, arguments, context);
+    auto object = object_->Execute(closure, context);
+    auto* instance = object.TryAs<runtime::ClassInstance>();
+
+    if (const auto* cls = &instance->GetClass(); cls != cached_class_) {
+        cached_class_ = cls;
+        cached_method_ = cls->GetMethod(method_);
+    }
+
+    if (!cached_method_ || cached_method_->param_symbols.size() != arguments.size()) {
+        throw runtime_error("Method "s + method_.GetName() + " has not found"s);
+    }
+
+    return instance->CallMethod(cached_method_, arguments, context);
 }
 
 ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::Stringify");
     if (auto object = argument_->Execute(closure, context)) {
-        ostringstream os;
-        object->Print(os, context);
-        return ObjectHolder::Own(runtime::String(os.str()));
+        return runtime::MakeString(context.Represent(*object));
     }
 
-    return ObjectHolder::Own(runtime::String("None"s));
+    return runtime::MakeString("None"s);
 }
 
 ObjectHolder Add::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::Add");
     auto lhs = lhs_->Execute(closure, context);
     auto rhs = rhs_->Execute(closure, context);
 
     if (lhs && rhs) {
         if (auto result = Addition<runtime::Number>(lhs, rhs)) {
             return *result;
-        } if (auto result = Addition<runtime::String>(lhs, rhs)) {
-            return *result;
+        } if (lhs.TryAs<runtime::String>() != nullptr) {
+            if (rhs.TryAs<runtime::String>() != nullptr) {
+                return runtime::String::Concat(lhs, rhs);
+            }
+
+            throw std::runtime_error("Unsupported operand type(s) for +");
         } else if (auto* left = lhs.TryAs<runtime::ClassInstance>()) {
             if (left->HasMethod(ADD_METHOD, 1U)) {
                 return left->Call(ADD_METHOD, {rhs}, context);
@@ -133,13 +217,14 @@ ObjectHolder Add::Execute(Closure& closure, Context& context) {
 }
 
 ObjectHolder Sub::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::Sub");
     auto lhs = lhs_->Execute(closure, context);
     auto rhs = rhs_->Execute(closure, context);
 
     if (lhs && rhs) {
         if (auto* left = lhs.TryAs<runtime::Number>()) {
             if (auto* right = rhs.TryAs<runtime::Number>()) {
-                return runtime::ObjectHolder::Own(runtime::Number(left->GetValue() - right->GetValue()));
+                return runtime::MakeNumber(left->GetValue() - right->GetValue());
             }
         }
     }
@@ -148,13 +233,14 @@ ObjectHolder Sub::Execute(Closure& closure, Context& context) {
 }
 
 ObjectHolder Mult::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::Mult");
     auto lhs = lhs_->Execute(closure, context);
     auto rhs = rhs_->Execute(closure, context);
 
     if (lhs && rhs) {
         if (auto* left = lhs.TryAs<runtime::Number>()) {
             if (auto* right = rhs.TryAs<runtime::Number>()) {
-                return runtime::ObjectHolder::Own(runtime::Number(left->GetValue() * right->GetValue()));
+                return runtime::MakeNumber(left->GetValue() * right->GetValue());
             }
         }
     }
@@ -163,6 +249,7 @@ ObjectHolder Mult::Execute(Closure& closure, Context& context) {
 }
 
 ObjectHolder Div::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::Div");
     auto lhs = lhs_->Execute(closure, context);
     auto rhs = rhs_->Execute(closure, context);
 
@@ -170,7 +257,7 @@ ObjectHolder Div::Execute(Closure& closure, Context& context) {
         if (auto* left = lhs.TryAs<runtime::Number>()) {
             if (auto* right = rhs.TryAs<runtime::Number>()) {
                 if (right->GetValue() > 0) {
-                    return runtime::ObjectHolder::Own(runtime::Number(left->GetValue() / right->GetValue()));
+                    return runtime::MakeNumber(left->GetValue() / right->GetValue());
                 }
 
                 throw std::runtime_error("Division by zero");
@@ -182,15 +269,24 @@ ObjectHolder Div::Execute(Closure& closure, Context& context) {
 }
 
 ObjectHolder Compound::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::Compound");
     for (auto& statement : statements_) {
         statement->Execute(closure, context);
+
+        // Внутри выполнилась инструкция return - прекращаем выполнение,
+        // флаг возврата снимет MethodBody
+        if (context.IsReturning()) {
+            break;
+        }
     }
 
     return ObjectHolder::None();
 }
 
 ObjectHolder Return::Execute(Closure& closure, Context& context) {
-    throw ReturnException{statement_->Execute(closure, context)};
+    MYTHON_PROFILE_SCOPE("ast::Return");
+    context.SignalReturn(statement_->Execute(closure, context));
+    return ObjectHolder::None();
 }
 
 ClassDefinition::ClassDefinition(ObjectHolder cls) :
@@ -198,20 +294,26 @@ ClassDefinition::ClassDefinition(ObjectHolder cls) :
 }
 
 ObjectHolder ClassDefinition::Execute(Closure& closure, Context& /*context*/) {
+    MYTHON_PROFILE_SCOPE("ast::ClassDefinition");
     return closure[cls_.TryAs<runtime::Class>()->GetName()] = cls_;
 }
 
-FieldAssignment::FieldAssignment(VariableValue object, std::string field_name,
+FieldAssignment::FieldAssignment(VariableValue object, runtime::Symbol field_name,
                                  std::unique_ptr<Statement> rv) :
     object_(move(object)),
-    field_name_(move(field_name)),
-    rv_(move(rv)) {
+    field_name_(field_name),
+    rv_(move(rv)),
+    field_site_{field_name, nullptr, runtime::Closure::NPOS} {
 }
 
 ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::FieldAssignment");
     auto object = object_.Execute(closure, context);
     auto* instance = object.TryAs<runtime::ClassInstance>();
-    return instance->Fields()[field_name_] = rv_->Execute(closure, context);
+    // Значение вычисляется до разрешения слота: выражение может само
+    // добавить поля и сместить кэшируемую позицию
+    auto value = rv_->Execute(closure, context);
+    return runtime::ResolveField(*instance, field_site_) = std::move(value);
 }
 
 IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
@@ -222,44 +324,70 @@ IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement>
 }
 
 ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
-    if (IsTrue(condition_->Execute(closure, context))) {
+    MYTHON_PROFILE_SCOPE("ast::IfElse");
+    if (condition_->ExecuteCondition(closure, context)) {
         return if_body_->Execute(closure, context);
     }
 
     return else_body_ ? else_body_->Execute(closure, context) : ObjectHolder::None();
 }
 
+While::While(unique_ptr<Statement> condition, unique_ptr<Statement> body) :
+    condition_(move(condition)),
+    body_(move(body)) {
+}
+
+ObjectHolder While::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::While");
+    while (condition_->ExecuteCondition(closure, context)) {
+        body_->Execute(closure, context);
+
+        if (context.IsReturning()) {
+            break;
+        }
+    }
+
+    return ObjectHolder::None();
+}
+
 ObjectHolder Or::Execute(Closure& closure, Context& context) {
-    return ObjectHolder::Own(runtime::Bool(
-        IsTrue(lhs_->Execute(closure, context)) ||
-        IsTrue(rhs_->Execute(closure, context))
-    ));
+    MYTHON_PROFILE_SCOPE("ast::Or");
+    return runtime::MakeBool(ExecuteCondition(closure, context));
+}
+
+bool Or::ExecuteCondition(Closure& closure, Context& context) {
+    return lhs_->ExecuteCondition(closure, context) ||
+           rhs_->ExecuteCondition(closure, context);
 }
 
 ObjectHolder And::Execute(Closure& closure, Context& context) {
-    return ObjectHolder::Own(runtime::Bool(
-        IsTrue(lhs_->Execute(closure, context)) &&
-        IsTrue(rhs_->Execute(closure, context))
-    ));
+    MYTHON_PROFILE_SCOPE("ast::And");
+    return runtime::MakeBool(ExecuteCondition(closure, context));
+}
+
+bool And::ExecuteCondition(Closure& closure, Context& context) {
+    return lhs_->ExecuteCondition(closure, context) &&
+           rhs_->ExecuteCondition(closure, context);
 }
 
 ObjectHolder Not::Execute(Closure& closure, Context& context) {
-    return ObjectHolder::Own(runtime::Bool(
-        !IsTrue(argument_->Execute(closure, context))
-    ));
+    MYTHON_PROFILE_SCOPE("ast::Not");
+    return runtime::MakeBool(ExecuteCondition(closure, context));
 }
 
-Comparison::Comparison(Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs)
-    : BinaryOperation(std::move(lhs), std::move(rhs)),
-    cmp_(cmp) {
+bool Not::ExecuteCondition(Closure& closure, Context& context) {
+    return !argument_->ExecuteCondition(closure, context);
 }
 
-ObjectHolder Comparison::Execute(Closure& closure, Context& context) {
-    return ObjectHolder::Own(runtime::Bool(cmp_(
-        lhs_->Execute(closure, context),
-        rhs_->Execute(closure, context),
-        context
-    )));
+template <CompareFn Cmp>
+ObjectHolder Comparison<Cmp>::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::Comparison");
+    return runtime::MakeBool(ExecuteCondition(closure, context));
+}
+
+template <CompareFn Cmp>
+bool Comparison<Cmp>::ExecuteCondition(Closure& closure, Context& context) {
+    return Cmp(lhs_->Execute(closure, context), rhs_->Execute(closure, context), context);
 }
 
 NewInstance::NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args) :
@@ -272,11 +400,12 @@ NewInstance::NewInstance(const runtime::Class& class_) :
 }
 
 ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
+    MYTHON_PROFILE_SCOPE("ast::NewInstance");
     auto object = ObjectHolder::Own(runtime::ClassInstance{class_});
     auto* instance = object.TryAs<runtime::ClassInstance>();
 
     if (instance->HasMethod(INIT_METHOD, args_.size())) {
-        vector<ObjectHolder> params;
+        runtime::ArgList params;
 
         for (auto& var : args_) {
             params.push_back(var->Execute(closure, context));
@@ -289,16 +418,301 @@ ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
 }
 
 MethodBody::MethodBody(std::unique_ptr<Statement>&& body) :
-    body_(move(body)) {
+    body_(ast::Fold(move(body))) {
+    vm::Compiler compiler;
+    compiler.CompileNode(*body_);
+    chunk_ = make_unique<vm::Chunk>(compiler.Release());
 }
 
 ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
-    try {
-        body_->Execute(closure, context);
-        return ObjectHolder::None();
-    } catch(const Return::ReturnException& e) {
-        return e.result;
+    MYTHON_PROFILE_SCOPE("ast::MethodBody");
+    auto result = vm::Run(*chunk_, closure, context);
+    return context.IsReturning() ? context.TakeReturnValue() : result;
+}
+
+template <typename T>
+bool ValueStatement<T>::Compile(vm::Compiler& compiler) {
+    compiler.Emit(vm::Op::Const, compiler.AddConstant(value_));
+    return true;
+}
+
+template class ValueStatement<runtime::Number>;
+template class ValueStatement<runtime::String>;
+template class ValueStatement<runtime::Bool>;
+
+bool None::Compile(vm::Compiler& compiler) {
+    compiler.Emit(vm::Op::PushNone);
+    return true;
+}
+
+bool VariableValue::Compile(vm::Compiler& compiler) {
+    compiler.Emit(vm::Op::LoadName, compiler.AddName(dotted_ids_.front()));
+
+    for (auto it = dotted_ids_.begin() + 1; it != dotted_ids_.end(); ++it) {
+        compiler.Emit(vm::Op::LoadField, compiler.AddFieldSite(*it));
     }
+
+    return true;
+}
+
+bool Assignment::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*rv_);
+    compiler.Emit(vm::Op::StoreName, compiler.AddName(var_));
+    return true;
+}
+
+bool FieldAssignment::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(object_);
+    compiler.CompileNode(*rv_);
+    compiler.Emit(vm::Op::StoreField, compiler.AddFieldSite(field_name_));
+    return true;
+}
+
+bool Print::Compile(vm::Compiler& compiler) {
+    // Аргументы вычисляются и печатаются по одному: вычисление очередного
+    // аргумента может изменить объекты, напечатанные предыдущими
+    bool is_first = true;
+
+    for (auto& arg : args_) {
+        compiler.CompileNode(*arg);
+        compiler.Emit(vm::Op::PrintValue, is_first ? 0 : 1);
+        is_first = false;
+    }
+
+    compiler.Emit(vm::Op::PrintEnd);
+    return true;
+}
+
+bool Add::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*lhs_);
+    compiler.CompileNode(*rhs_);
+    compiler.Emit(vm::Op::Add);
+    return true;
+}
+
+bool Sub::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*lhs_);
+    compiler.CompileNode(*rhs_);
+    compiler.Emit(vm::Op::Sub);
+    return true;
+}
+
+bool Mult::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*lhs_);
+    compiler.CompileNode(*rhs_);
+    compiler.Emit(vm::Op::Mult);
+    return true;
+}
+
+bool Div::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*lhs_);
+    compiler.CompileNode(*rhs_);
+    compiler.Emit(vm::Op::Div);
+    return true;
+}
+
+bool Or::Compile(vm::Compiler& compiler) {
+    // Короткое замыкание: rhs вычисляется, только если lhs ложен
+    compiler.CompileNode(*lhs_);
+    auto lhs_true = compiler.EmitJump(vm::Op::JumpIfTrue);
+    compiler.CompileNode(*rhs_);
+    auto rhs_true = compiler.EmitJump(vm::Op::JumpIfTrue);
+    compiler.Emit(vm::Op::Const, compiler.AddConstant(runtime::MakeBool(false)));
+    auto end = compiler.EmitJump(vm::Op::Jump);
+    compiler.PatchJump(lhs_true);
+    compiler.PatchJump(rhs_true);
+    compiler.Emit(vm::Op::Const, compiler.AddConstant(runtime::MakeBool(true)));
+    compiler.PatchJump(end);
+    return true;
+}
+
+bool And::Compile(vm::Compiler& compiler) {
+    // Короткое замыкание: rhs вычисляется, только если lhs истинен
+    compiler.CompileNode(*lhs_);
+    auto lhs_false = compiler.EmitJump(vm::Op::JumpIfFalse);
+    compiler.CompileNode(*rhs_);
+    auto rhs_false = compiler.EmitJump(vm::Op::JumpIfFalse);
+    compiler.Emit(vm::Op::Const, compiler.AddConstant(runtime::MakeBool(true)));
+    auto end = compiler.EmitJump(vm::Op::Jump);
+    compiler.PatchJump(lhs_false);
+    compiler.PatchJump(rhs_false);
+    compiler.Emit(vm::Op::Const, compiler.AddConstant(runtime::MakeBool(false)));
+    compiler.PatchJump(end);
+    return true;
+}
+
+bool Not::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*argument_);
+    compiler.Emit(vm::Op::Not);
+    return true;
+}
+
+template <CompareFn Cmp>
+bool Comparison<Cmp>::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*lhs_);
+    compiler.CompileNode(*rhs_);
+    compiler.Emit(vm::Op::Compare, compiler.AddCompare(Cmp));
+    return true;
+}
+
+template class Comparison<runtime::Less>;
+template class Comparison<runtime::Greater>;
+template class Comparison<runtime::Equal>;
+template class Comparison<runtime::NotEqual>;
+template class Comparison<runtime::LessOrEqual>;
+template class Comparison<runtime::GreaterOrEqual>;
+
+bool Compound::Compile(vm::Compiler& compiler) {
+    for (auto& statement : statements_) {
+        compiler.CompileNode(*statement);
+        compiler.Emit(vm::Op::Pop);
+    }
+
+    compiler.Emit(vm::Op::PushNone);
+    return true;
+}
+
+bool IfElse::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*condition_);
+    auto to_else = compiler.EmitJump(vm::Op::JumpIfFalse);
+    compiler.CompileNode(*if_body_);
+    auto to_end = compiler.EmitJump(vm::Op::Jump);
+    compiler.PatchJump(to_else);
+
+    if (else_body_) {
+        compiler.CompileNode(*else_body_);
+    } else {
+        compiler.Emit(vm::Op::PushNone);
+    }
+
+    compiler.PatchJump(to_end);
+    return true;
+}
+
+bool While::Compile(vm::Compiler& compiler) {
+    const auto loop_start = compiler.CurrentPosition();
+    compiler.CompileNode(*condition_);
+    auto to_end = compiler.EmitJump(vm::Op::JumpIfFalse);
+    compiler.CompileNode(*body_);
+    compiler.Emit(vm::Op::Pop);
+    compiler.Emit(vm::Op::Jump, static_cast<uint32_t>(loop_start));
+    compiler.PatchJump(to_end);
+    compiler.Emit(vm::Op::PushNone);
+    return true;
+}
+
+bool Return::Compile(vm::Compiler& compiler) {
+    compiler.CompileNode(*statement_);
+    compiler.Emit(vm::Op::Return);
+    return true;
+}
+
+unique_ptr<Statement> UnaryOperation::Fold() {
+    argument_ = ast::Fold(move(argument_));
+
+    if (argument_->IsConstant()) {
+        return EvaluateConstant(*this);
+    }
+
+    return nullptr;
+}
+
+unique_ptr<Statement> BinaryOperation::Fold() {
+    lhs_ = ast::Fold(move(lhs_));
+    rhs_ = ast::Fold(move(rhs_));
+
+    if (lhs_->IsConstant() && rhs_->IsConstant()) {
+        return EvaluateConstant(*this);
+    }
+
+    return nullptr;
+}
+
+unique_ptr<Statement> While::Fold() {
+    condition_ = ast::Fold(move(condition_));
+    body_ = ast::Fold(move(body_));
+    return nullptr;
+}
+
+unique_ptr<Statement> IfElse::Fold() {
+    condition_ = ast::Fold(move(condition_));
+    if_body_ = ast::Fold(move(if_body_));
+    else_body_ = ast::Fold(move(else_body_));
+
+    if (condition_->IsConstant()) {
+        runtime::Closure closure;
+        runtime::DummyContext context;
+
+        if (IsTrue(condition_->Execute(closure, context))) {
+            return move(if_body_);
+        }
+
+        return else_body_ ? move(else_body_) : make_unique<None>();
+    }
+
+    return nullptr;
+}
+
+unique_ptr<Statement> Compound::Fold() {
+    vector<unique_ptr<Statement>> flattened;
+    flattened.reserve(statements_.size());
+
+    for (auto& statement : statements_) {
+        statement = ast::Fold(move(statement));
+
+        // Вложенный Compound сплющивается в объемлющий
+        if (auto* inner = dynamic_cast<Compound*>(statement.get())) {
+            for (auto& child : inner->statements_) {
+                flattened.push_back(move(child));
+            }
+        } else {
+            flattened.push_back(move(statement));
+        }
+    }
+
+    statements_ = move(flattened);
+    return nullptr;
+}
+
+unique_ptr<Statement> Return::Fold() {
+    statement_ = ast::Fold(move(statement_));
+    return nullptr;
+}
+
+unique_ptr<Statement> Assignment::Fold() {
+    rv_ = ast::Fold(move(rv_));
+    return nullptr;
+}
+
+unique_ptr<Statement> FieldAssignment::Fold() {
+    rv_ = ast::Fold(move(rv_));
+    return nullptr;
+}
+
+unique_ptr<Statement> Print::Fold() {
+    for (auto& arg : args_) {
+        arg = ast::Fold(move(arg));
+    }
+
+    return nullptr;
+}
+
+unique_ptr<Statement> MethodCall::Fold() {
+    object_ = ast::Fold(move(object_));
+
+    for (auto& arg : args_) {
+        arg = ast::Fold(move(arg));
+    }
+
+    return nullptr;
+}
+
+unique_ptr<Statement> NewInstance::Fold() {
+    for (auto& arg : args_) {
+        arg = ast::Fold(move(arg));
+    }
+
+    return nullptr;
 }
 
 }  // namespace ast
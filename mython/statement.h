@@ -2,33 +2,50 @@
 
 #include "runtime.h"
 
-#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 #include <optional>
 #include <stdexcept>
 
+namespace vm {
+struct Chunk;
+}
+
 namespace ast {
 
 using Statement = runtime::Executable;
 
+// Проход упрощения дерева: константная арифметика, сравнения и логика
+// сворачиваются в константы, ветка if с константным условием выбирается
+// сразу, вложенные Compound сплющиваются. Выполняется над результатом
+// ParseProgram и над телами методов перед компиляцией в байт-код
+std::unique_ptr<Statement> Fold(std::unique_ptr<Statement> node);
+
 // Выражение, возвращающее значение типа T,
 // используется как основа для создания констант
 template <typename T>
 class ValueStatement : public Statement {
 public:
     explicit ValueStatement(T v)
-        : value_(std::move(v)) {
+        : value_(runtime::ObjectHolder::Own(std::move(v))) {
     }
 
     runtime::ObjectHolder Execute(runtime::Closure& /*closure*/,
                                   runtime::Context& /*context*/) override {
-        return runtime::ObjectHolder::Share(value_);
+        // Узел владеет значением через счётчик ссылок: результат остаётся
+        // действительным и после уничтожения дерева (потоковый режим)
+        return value_;
+    }
+
+    bool Compile(vm::Compiler& compiler) override;
+
+    [[nodiscard]] bool IsConstant() const override {
+        return true;
     }
 
 private:
-    T value_;
+    runtime::ObjectHolder value_;
 };
 
 using NumericConst = ValueStatement<runtime::Number>;
@@ -42,50 +59,57 @@ x = circle.center.x
 */
 class VariableValue : public Statement {
 public:
+    explicit VariableValue(runtime::Symbol var_name);
     explicit VariableValue(const std::string& var_name);
-    explicit VariableValue(std::vector<std::string> dotted_ids);
+    explicit VariableValue(std::vector<runtime::Symbol> dotted_ids);
+    explicit VariableValue(const std::vector<std::string>& dotted_ids);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
-private:
-    static runtime::ObjectHolder GetVarByName(runtime::Closure& closure, const std::string& name);
-
-    template<typename InputIt>
-    static runtime::ObjectHolder GetVarByNameRange(InputIt first, InputIt last, runtime::ObjectHolder& object) {
-        if (first == last) {
-            return object;
-        }
-
-        auto* instance = object.TryAs<runtime::ClassInstance>();
-        return GetVarByNameRange(first + 1, last, instance->Fields()[*first]);
-    }
+    bool Compile(vm::Compiler& compiler) override;
 
-    std::vector<std::string> dotted_ids_;
+private:
+    std::vector<runtime::Symbol> dotted_ids_;
+    // Кэш позиции первого имени в кадре и позиций полей -
+    // по одному на каждый шаг цепочки после первого
+    runtime::NameSite name_site_;
+    std::vector<runtime::FieldSite> field_sites_;
 };
 
 // Присваивает переменной, имя которой задано в параметре var, значение выражения rv
 class Assignment : public Statement {
 public:
-    Assignment(std::string var, std::unique_ptr<Statement> rv);
+    Assignment(runtime::Symbol var, std::unique_ptr<Statement> rv);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    bool Compile(vm::Compiler& compiler) override;
+
+    std::unique_ptr<Statement> Fold() override;
+
 private:
-    std::string var_;
+    runtime::Symbol var_;
     std::unique_ptr<Statement> rv_;
 };
 
 // Присваивает полю object.field_name значение выражения rv
 class FieldAssignment : public Statement {
 public:
-    FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv);
+    FieldAssignment(VariableValue object, runtime::Symbol field_name,
+                    std::unique_ptr<Statement> rv);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    bool Compile(vm::Compiler& compiler) override;
+
+    std::unique_ptr<Statement> Fold() override;
+
 private:
     VariableValue object_;
-    std::string field_name_;
+    runtime::Symbol field_name_;
     std::unique_ptr<Statement> rv_;
+    // Кэш позиции поля field_name_ в экземплярах объекта object_
+    runtime::FieldSite field_site_;
 };
 
 // Значение None
@@ -95,6 +119,12 @@ public:
                                   [[maybe_unused]] runtime::Context& context) override {
         return {};
     }
+
+    bool Compile(vm::Compiler& compiler) override;
+
+    [[nodiscard]] bool IsConstant() const override {
+        return true;
+    }
 };
 
 // Команда print
@@ -112,6 +142,10 @@ public:
     // context.GetOutputStream()
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    bool Compile(vm::Compiler& compiler) override;
+
+    std::unique_ptr<Statement> Fold() override;
+
 private:
     std::vector<std::unique_ptr<Statement>> args_;
 };
@@ -119,15 +153,21 @@ private:
 // Вызывает метод object.method со списком параметров args
 class MethodCall : public Statement {
 public:
-    MethodCall(std::unique_ptr<Statement> object, std::string method,
+    MethodCall(std::unique_ptr<Statement> object, runtime::Symbol method,
                std::vector<std::unique_ptr<Statement>> args);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    std::unique_ptr<Statement> Fold() override;
+
 private:
     std::unique_ptr<Statement> object_;
-    std::string method_;
+    runtime::Symbol method_;
     std::vector<std::unique_ptr<Statement>> args_;
+    // Мономорфный inline-кэш: пока класс объекта в этой точке вызова
+    // не меняется, метод не ищется заново по таблице
+    const runtime::Class* cached_class_ = nullptr;
+    const runtime::Method* cached_method_ = nullptr;
 };
 
 /*
@@ -149,6 +189,9 @@ public:
     NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args);
     // Возвращает объект, содержащий значение типа ClassInstance
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    std::unique_ptr<Statement> Fold() override;
+
 private:
     const runtime::Class& class_;
     std::vector<std::unique_ptr<Statement>> args_;
@@ -161,6 +204,8 @@ public:
         argument_(std::move(argument)) {
     }
 
+    std::unique_ptr<Statement> Fold() override;
+
 protected:
     std::unique_ptr<Statement> argument_;
 };
@@ -180,6 +225,8 @@ public:
         rhs_(move(rhs)) {
     }
 
+    std::unique_ptr<Statement> Fold() override;
+
 protected:
     std::unique_ptr<Statement> lhs_;
     std::unique_ptr<Statement> rhs_;
@@ -197,6 +244,8 @@ public:
     // В противном случае при вычислении выбрасывается runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    bool Compile(vm::Compiler& compiler) override;
+
 private:
     template<typename T>
     static std::optional<runtime::ObjectHolder> Addition(runtime::ObjectHolder& lhs, runtime::ObjectHolder& rhs) {
@@ -221,6 +270,8 @@ public:
     //  число - число
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    bool Compile(vm::Compiler& compiler) override;
 };
 
 // Возвращает результат умножения аргументов lhs и rhs
@@ -232,6 +283,8 @@ public:
     //  число * число
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    bool Compile(vm::Compiler& compiler) override;
 };
 
 // Возвращает результат деления lhs и rhs
@@ -244,6 +297,8 @@ public:
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     // Если rhs равен 0, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    bool Compile(vm::Compiler& compiler) override;
 };
 
 // Возвращает результат вычисления логической операции or над lhs и rhs
@@ -253,6 +308,9 @@ public:
     // Значение аргумента rhs вычисляется, только если значение lhs
     // после приведения к Bool равно False
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    bool ExecuteCondition(runtime::Closure& closure, runtime::Context& context) override;
+
+    bool Compile(vm::Compiler& compiler) override;
 };
 
 // Возвращает результат вычисления логической операции and над lhs и rhs
@@ -262,6 +320,9 @@ public:
     // Значение аргумента rhs вычисляется, только если значение lhs
     // после приведения к Bool равно True
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    bool ExecuteCondition(runtime::Closure& closure, runtime::Context& context) override;
+
+    bool Compile(vm::Compiler& compiler) override;
 };
 
 // Возвращает результат вычисления логической операции not над единственным аргументом операции
@@ -269,6 +330,9 @@ class Not : public UnaryOperation {
 public:
     using UnaryOperation::UnaryOperation;
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    bool ExecuteCondition(runtime::Closure& closure, runtime::Context& context) override;
+
+    bool Compile(vm::Compiler& compiler) override;
 };
 
 // Составная инструкция (например: тело метода, содержимое ветки if, либо else)
@@ -288,6 +352,10 @@ public:
     // Последовательно выполняет добавленные инструкции. Возвращает None
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    bool Compile(vm::Compiler& compiler) override;
+
+    std::unique_ptr<Statement> Fold() override;
+
 private:
     std::vector<std::unique_ptr<Statement>> statements_;
 };
@@ -304,15 +372,13 @@ public:
 
 private:
     std::unique_ptr<Statement> body_;
+    // Байт-код тела метода, компилируется один раз в конструкторе
+    std::unique_ptr<vm::Chunk> chunk_;
 };
 
 // Выполняет инструкцию return с выражением statement
 class Return : public Statement {
 public:
-    struct ReturnException {
-        runtime::ObjectHolder result;
-    };
-
     explicit Return(std::unique_ptr<Statement> statement) :
         statement_(move(statement)) {
     }
@@ -321,6 +387,10 @@ public:
     // внутри которого она была исполнена, должен вернуть результат вычисления выражения statement.
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    bool Compile(vm::Compiler& compiler) override;
+
+    std::unique_ptr<Statement> Fold() override;
+
 private:
     std::unique_ptr<Statement> statement_;
 };
@@ -348,27 +418,52 @@ public:
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    bool Compile(vm::Compiler& compiler) override;
+
+    std::unique_ptr<Statement> Fold() override;
+
 private:
     std::unique_ptr<Statement> condition_;
     std::unique_ptr<Statement> if_body_;
     std::unique_ptr<Statement> else_body_;
 };
 
-// Операция сравнения
-class Comparison : public BinaryOperation {
+// Цикл while
+class While : public Statement {
 public:
-    // Comparator задаёт функцию, выполняющую сравнение значений аргументов
-    using Comparator = std::function<bool(const runtime::ObjectHolder&,
-                                          const runtime::ObjectHolder&, runtime::Context&)>;
-
-    Comparison(Comparator cmp, std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs);
+    While(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> body);
 
-    // Вычисляет значение выражений lhs и rhs и возвращает результат работы comparator,
-    // приведённый к типу runtime::Bool
+    // Вычисляет condition и выполняет body, пока условие истинно.
+    // Итерации идут на месте, без рекурсии - глубина стека C++ не растёт
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    bool Compile(vm::Compiler& compiler) override;
+
+    std::unique_ptr<Statement> Fold() override;
+
 private:
-    Comparator cmp_;
+    std::unique_ptr<Statement> condition_;
+    std::unique_ptr<Statement> body_;
+};
+
+// Сигнатура функций сравнения runtime::Equal, runtime::Less и т.п.
+using CompareFn = bool (*)(const runtime::ObjectHolder&, const runtime::ObjectHolder&,
+                           runtime::Context&);
+
+// Операция сравнения. Компаратор задан параметром шаблона: Execute вызывает
+// runtime::Equal/Less и т.п. напрямую, без косвенного вызова через
+// std::function, а ExecuteCondition отдаёт результат без упаковки в Bool
+template <CompareFn Cmp>
+class Comparison : public BinaryOperation {
+public:
+    using BinaryOperation::BinaryOperation;
+
+    // Вычисляет значение выражений lhs и rhs и возвращает результат
+    // сравнения, приведённый к типу runtime::Bool
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    bool ExecuteCondition(runtime::Closure& closure, runtime::Context& context) override;
+
+    bool Compile(vm::Compiler& compiler) override;
 };
 
 }  // namespace ast
@@ -0,0 +1,69 @@
+#include "symbol.h"
+
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Глобальная таблица символов: каноническая строка каждого имени
+// хранится в деке (адреса стабильны), номер - индекс в ней.
+// Таблица одна на процесс, поэтому доступ защищён мьютексом:
+// интернирование происходит при разборе, а не на каждой операции,
+// так что в горячий путь исполнения блокировка не попадает
+struct SymbolTable {
+    SymbolTable() {
+        // Номер 0 зарезервирован за пустой строкой - значением Symbol по умолчанию
+        Intern({});
+    }
+
+    uint32_t Intern(string_view name) {
+        lock_guard lock(guard);
+
+        if (auto it = ids.find(name); it != ids.end()) {
+            return it->second;
+        }
+
+        const auto id = static_cast<uint32_t>(names.size());
+        const auto& stored = names.emplace_back(name);
+        ids.emplace(stored, id);
+        return id;
+    }
+
+    const string& NameOf(uint32_t id) {
+        // Строки после интернирования не меняются, блокировка нужна лишь
+        // на время индексации деки, растущей из других потоков
+        lock_guard lock(guard);
+        return names[id];
+    }
+
+    mutex guard;
+    deque<string> names;
+    unordered_map<string_view, uint32_t> ids;
+};
+
+SymbolTable& GetSymbolTable() {
+    static SymbolTable table;
+    return table;
+}
+
+}  // namespace
+
+Symbol::Symbol(string_view name) :
+    id_(GetSymbolTable().Intern(name)) {
+}
+
+const string& Symbol::GetName() const {
+    return GetSymbolTable().NameOf(id_);
+}
+
+ostream& operator<<(ostream& os, Symbol symbol) {
+    return os << symbol.GetName();
+}
+
+}  // namespace runtime
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace runtime {
+
+/*
+ * Интернированный идентификатор. Каждое имя (переменной, метода, поля)
+ * хранится в глобальной таблице символов в единственном экземпляре,
+ * а Symbol - лишь его целочисленный номер. Сравнение и хеширование символов -
+ * операции над целыми числами, без обращения к самим строкам.
+ *
+ * Symbol неявно конструируется из строки, поэтому существующий код,
+ * работающий с именами-строками, продолжает работать без изменений
+ */
+class Symbol {
+public:
+    // Символ пустой строки
+    Symbol() = default;
+
+    Symbol(std::string_view name);      // NOLINT(google-explicit-constructor)
+    Symbol(const std::string& name)     // NOLINT(google-explicit-constructor)
+        : Symbol(std::string_view(name)) {
+    }
+    Symbol(const char* name)            // NOLINT(google-explicit-constructor)
+        : Symbol(std::string_view(name)) {
+    }
+
+    [[nodiscard]] std::uint32_t GetId() const {
+        return id_;
+    }
+
+    // Возвращает каноническую строку символа из таблицы
+    [[nodiscard]] const std::string& GetName() const;
+
+private:
+    std::uint32_t id_ = 0;
+};
+
+inline bool operator==(Symbol lhs, Symbol rhs) {
+    return lhs.GetId() == rhs.GetId();
+}
+
+inline bool operator!=(Symbol lhs, Symbol rhs) {
+    return !(lhs == rhs);
+}
+
+std::ostream& operator<<(std::ostream& os, Symbol symbol);
+
+}  // namespace runtime
+
+template <>
+struct std::hash<runtime::Symbol> {
+    std::size_t operator()(runtime::Symbol symbol) const noexcept {
+        // Номера символов плотные, домножение на простое число разбрасывает их по корзинам
+        return static_cast<std::size_t>(symbol.GetId()) * 2654435761U;
+    }
+};
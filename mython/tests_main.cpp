@@ -0,0 +1,172 @@
+#include "interpreter.h"
+#include "test_runner_p.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace parse {
+void RunOpenLexerTests(TestRunner& tr);
+}  // namespace parse
+
+namespace cache {
+void RunCacheTests(TestRunner& tr);
+}  // namespace cache
+
+namespace pool {
+void RunInterpreterPoolTests(TestRunner& tr);
+}  // namespace pool
+
+namespace ast {
+void RunUnitTests(TestRunner& tr);
+}
+namespace runtime {
+void RunObjectHolderTests(TestRunner& tr);
+void RunObjectsTests(TestRunner& tr);
+}  // namespace runtime
+
+void TestParseProgram(TestRunner& tr);
+
+namespace {
+
+void TestSimplePrints() {
+    istringstream input(R"(
+print 57
+print 10, 24, -8
+print 'hello'
+print "world"
+print True, False
+print
+print None
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
+}
+
+void TestAssignments() {
+    istringstream input(R"(
+x = 57
+print x
+x = 'C++ black belt'
+print x
+y = False
+x = y
+print x
+x = None
+print x, y
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
+}
+
+void TestArithmetics() {
+    istringstream input("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
+}
+
+void TestVariablesArePointers() {
+    istringstream input(R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add():
+    self.value = self.value + 1
+
+class Dummy:
+  def do_add(counter):
+    counter.add()
+
+x = Counter()
+y = x
+
+x.add()
+y.add()
+
+print x.value
+
+d = Dummy()
+d.do_add(x)
+
+print y.value
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "2\n3\n");
+}
+
+void TestWhileLoop() {
+    istringstream input(R"(
+i = 0
+sum = 0
+while i < 5:
+  sum = sum + i
+  i = i + 1
+print sum, i
+
+class Acc:
+  def __init__(n):
+    self.total = 0
+    k = 0
+    while k < n:
+      self.total = self.total + k
+      k = k + 1
+
+  def first_over(limit):
+    k = 1
+    while True:
+      if k * k > limit:
+        return k
+      k = k + 1
+
+a = Acc(10)
+print a.total, a.first_over(50)
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "10 5\n45 8\n");
+}
+
+void TestAll() {
+    TestRunner tr;
+    parse::RunOpenLexerTests(tr);
+    cache::RunCacheTests(tr);
+    pool::RunInterpreterPoolTests(tr);
+    runtime::RunObjectHolderTests(tr);
+    runtime::RunObjectsTests(tr);
+    ast::RunUnitTests(tr);
+    TestParseProgram(tr);
+
+    RUN_TEST(tr, TestSimplePrints);
+    RUN_TEST(tr, TestAssignments);
+    RUN_TEST(tr, TestArithmetics);
+    RUN_TEST(tr, TestVariablesArePointers);
+    RUN_TEST(tr, TestWhileLoop);
+}
+
+}  // namespace
+
+int main() {
+    try {
+        TestAll();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,327 @@
+#include "vm.h"
+
+#include "profiler.h"
+
+#include <array>
+
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace vm {
+
+using runtime::ClassInstance;
+using runtime::Closure;
+using runtime::Context;
+using runtime::ObjectHolder;
+
+namespace details {
+
+const runtime::Symbol ADD_METHOD = "__add__"s;
+
+ObjectHolder ExecuteAdd(ObjectHolder& lhs, ObjectHolder& rhs, Context& context) {
+    if (lhs && rhs) {
+        if (auto* left = lhs.TryAs<runtime::Number>()) {
+            if (auto* right = rhs.TryAs<runtime::Number>()) {
+                return runtime::MakeNumber(left->GetValue() + right->GetValue());
+            }
+        } else if (lhs.TryAs<runtime::String>() != nullptr) {
+            if (rhs.TryAs<runtime::String>() != nullptr) {
+                return runtime::String::Concat(lhs, rhs);
+            }
+        } else if (auto* left = lhs.TryAs<ClassInstance>()) {
+            if (left->HasMethod(ADD_METHOD, 1U)) {
+                return left->Call(ADD_METHOD, {rhs}, context);
+            }
+        }
+    }
+
+    throw runtime_error("Unsupported operand type(s) for +: 'int' and 'str'"s);
+}
+
+const runtime::Number* AsNumber(const ObjectHolder& value) {
+    return value ? value.TryAs<runtime::Number>() : nullptr;
+}
+
+ClassInstance& AsInstance(const ObjectHolder& object) {
+    auto* instance = object.TryAs<ClassInstance>();
+
+    if (!instance) {
+        throw runtime_error("Object has no fields"s);
+    }
+
+    return *instance;
+}
+
+}  // namespace details
+
+void Compiler::CompileNode(runtime::Executable& node) {
+    if (!node.Compile(*this)) {
+        chunk_.statements.push_back(&node);
+        Emit(Op::ExecStatement, static_cast<uint32_t>(chunk_.statements.size() - 1));
+    }
+}
+
+uint32_t Compiler::AddConstant(ObjectHolder value) {
+    chunk_.constants.push_back(std::move(value));
+    return static_cast<uint32_t>(chunk_.constants.size() - 1);
+}
+
+uint32_t Compiler::AddName(runtime::Symbol name) {
+    chunk_.names.push_back(name);
+    chunk_.name_sites.push_back({name, runtime::Closure::NPOS});
+    return static_cast<uint32_t>(chunk_.names.size() - 1);
+}
+
+uint32_t Compiler::AddCompare(CompareFn fn) {
+    chunk_.compares.push_back(fn);
+    return static_cast<uint32_t>(chunk_.compares.size() - 1);
+}
+
+uint32_t Compiler::AddFieldSite(runtime::Symbol name) {
+    chunk_.field_sites.push_back({name, nullptr, runtime::Closure::NPOS});
+    return static_cast<uint32_t>(chunk_.field_sites.size() - 1);
+}
+
+void Compiler::Emit(Op op, uint32_t arg) {
+    chunk_.code.push_back({op, arg});
+}
+
+size_t Compiler::EmitJump(Op op) {
+    Emit(op);
+    return chunk_.code.size() - 1;
+}
+
+size_t Compiler::CurrentPosition() const {
+    return chunk_.code.size();
+}
+
+void Compiler::PatchJump(size_t jump_pos) {
+    chunk_.code[jump_pos].arg = static_cast<uint32_t>(chunk_.code.size());
+}
+
+Chunk Compiler::Release() {
+    return std::move(chunk_);
+}
+
+ObjectHolder Run(const Chunk& chunk, Closure& closure, Context& context) {
+    vector<ObjectHolder> stack;
+    stack.reserve(8);
+
+    auto pop = [&stack] {
+        auto value = std::move(stack.back());
+        stack.pop_back();
+        return value;
+    };
+
+#ifdef MYTHON_PROFILE
+    // Счётчики инструкций; имена совпадают с enum Op
+    static const auto op_counters = [] {
+        const char* names[] = {"op Const",        "op PushNone",   "op Pop",
+                               "op LoadName",     "op StoreName",  "op LoadField",
+                               "op StoreField",   "op Add",        "op Sub",
+                               "op Mult",         "op Div",        "op Compare",
+                               "op Not",          "op Jump",       "op JumpIfFalse",
+                               "op JumpIfTrue",   "op PrintValue", "op PrintEnd",
+                               "op ExecStatement", "op Return"};
+        std::array<profile::Counter*, std::size(names)> counters{};
+
+        for (size_t i = 0; i < std::size(names); ++i) {
+            counters[i] = &profile::MethodCounter(names[i]);
+        }
+
+        return counters;
+    }();
+#endif
+
+    for (size_t pc = 0; pc < chunk.code.size(); ++pc) {
+        const auto& [op, arg] = chunk.code[pc];
+
+#ifdef MYTHON_PROFILE
+        profile::Hit(*op_counters[static_cast<size_t>(op)]);
+#endif
+
+        switch (op) {
+            case Op::Const:
+                stack.push_back(chunk.constants[arg]);
+                break;
+
+            case Op::PushNone:
+                stack.emplace_back();
+                break;
+
+            case Op::Pop:
+                stack.pop_back();
+                break;
+
+            case Op::LoadName: {
+                auto& site = chunk.name_sites[arg];
+                auto* value = runtime::ResolveName(closure, site);
+
+                if (!value) {
+                    throw runtime_error("Name "s + site.name.GetName() + " is not defined"s);
+                }
+
+                stack.push_back(*value);
+                break;
+            }
+
+            case Op::StoreName:
+                closure[chunk.names[arg]] = stack.back();
+                break;
+
+            case Op::LoadField: {
+                auto object = pop();
+                auto& site = chunk.field_sites[arg];
+                auto* field = runtime::FindField(details::AsInstance(object), site);
+
+                if (!field) {
+                    throw runtime_error("Field "s + site.name.GetName() + " is not defined"s);
+                }
+
+                stack.push_back(*field);
+                break;
+            }
+
+            case Op::StoreField: {
+                auto value = pop();
+                auto object = pop();
+                runtime::ResolveField(details::AsInstance(object), chunk.field_sites[arg]) = value;
+                stack.push_back(std::move(value));
+                break;
+            }
+
+            case Op::Add: {
+                auto rhs = pop();
+                auto lhs = pop();
+                stack.push_back(details::ExecuteAdd(lhs, rhs, context));
+                break;
+            }
+
+            case Op::Sub: {
+                auto rhs = pop();
+                auto lhs = pop();
+
+                if (const auto* left = details::AsNumber(lhs)) {
+                    if (const auto* right = details::AsNumber(rhs)) {
+                        stack.push_back(runtime::MakeNumber(left->GetValue() - right->GetValue()));
+                        break;
+                    }
+                }
+
+                throw runtime_error("Unsupported operand type(s) for -");
+            }
+
+            case Op::Mult: {
+                auto rhs = pop();
+                auto lhs = pop();
+
+                if (const auto* left = details::AsNumber(lhs)) {
+                    if (const auto* right = details::AsNumber(rhs)) {
+                        stack.push_back(runtime::MakeNumber(left->GetValue() * right->GetValue()));
+                        break;
+                    }
+                }
+
+                throw runtime_error("Unsupported operand type(s) for *");
+            }
+
+            case Op::Div: {
+                auto rhs = pop();
+                auto lhs = pop();
+
+                if (const auto* left = details::AsNumber(lhs)) {
+                    if (const auto* right = details::AsNumber(rhs)) {
+                        if (right->GetValue() > 0) {
+                            stack.push_back(runtime::MakeNumber(left->GetValue() / right->GetValue()));
+                            break;
+                        }
+
+                        throw runtime_error("Division by zero");
+                    }
+                }
+
+                throw runtime_error("Unsupported operand type(s) for /");
+            }
+
+            case Op::Compare: {
+                auto rhs = pop();
+                auto lhs = pop();
+                stack.push_back(runtime::MakeBool(chunk.compares[arg](lhs, rhs, context)));
+                break;
+            }
+
+            case Op::Not:
+                // Операнд отрицается на месте: pop() в правой части
+                // вычислился бы первым, и back() указал бы под вершину
+                stack.back() = runtime::MakeBool(!runtime::IsTrue(stack.back()));
+                break;
+
+            // Переход выставляет pc на инструкцию перед целью - инкремент
+            // цикла доводит его до цели (для цели 0 счётчик обходит SIZE_MAX)
+            case Op::Jump:
+                pc = static_cast<size_t>(arg) - 1;
+                break;
+
+            case Op::JumpIfFalse:
+                if (!runtime::IsTrue(pop())) {
+                    pc = static_cast<size_t>(arg) - 1;
+                }
+                break;
+
+            case Op::JumpIfTrue:
+                if (runtime::IsTrue(pop())) {
+                    pc = static_cast<size_t>(arg) - 1;
+                }
+                break;
+
+            case Op::PrintValue: {
+                if (arg != 0) {
+                    context.Append(' ');
+                }
+
+                if (auto object = pop()) {
+                    object->PrintTo(context);
+                } else {
+                    context.Append("None"sv);
+                }
+                break;
+            }
+
+            case Op::PrintEnd:
+                context.Append('\n');
+                context.Flush();
+                stack.emplace_back();
+                break;
+
+            case Op::ExecStatement:
+                stack.push_back(chunk.statements[arg]->Execute(closure, context));
+
+                // Узел выполнил инструкцию return - фрагмент завершается,
+                // снимать флаг будет MethodBody объемлющего метода
+                if (context.IsReturning()) {
+                    return std::move(stack.back());
+                }
+                break;
+
+            case Op::Return:
+                return pop();
+        }
+    }
+
+    return stack.empty() ? ObjectHolder::None() : std::move(stack.back());
+}
+
+Program::Program(std::unique_ptr<runtime::Executable> root) :
+    root_(std::move(root)) {
+    Compiler compiler;
+    compiler.CompileNode(*root_);
+    chunk_ = compiler.Release();
+}
+
+ObjectHolder Program::Execute(Closure& closure, Context& context) {
+    return Run(chunk_, closure, context);
+}
+
+}  // namespace vm
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vm {
+
+// Сигнатура функций сравнения runtime::Equal, runtime::Less и т.д.
+using CompareFn = bool (*)(const runtime::ObjectHolder&, const runtime::ObjectHolder&,
+                           runtime::Context&);
+
+// Код операции виртуальной машины. Машина стековая: операнды инструкций
+// берутся с вершины стека значений, результат кладётся обратно на стек
+enum class Op : std::uint8_t {
+    Const,          // положить константу constants[arg] на стек
+    PushNone,       // положить None на стек
+    Pop,            // снять значение с вершины стека
+    LoadName,       // положить значение переменной names[arg] из closure
+    StoreName,      // записать вершину стека в переменную names[arg] (значение остаётся на стеке)
+    LoadField,      // снять объект, положить значение его поля names[arg]
+    StoreField,     // снять значение и объект, записать поле names[arg], вернуть значение на стек
+    Add,            // сложение двух верхних значений стека
+    Sub,            // вычитание
+    Mult,           // умножение
+    Div,            // деление
+    Compare,        // сравнение функцией compares[arg], результат - Bool
+    Not,            // логическое отрицание вершины стека, результат - Bool
+    Jump,           // безусловный переход на инструкцию arg
+    JumpIfFalse,    // снять значение, перейти на arg, если оно ложно
+    JumpIfTrue,     // снять значение, перейти на arg, если оно истинно
+    PrintValue,     // снять значение и напечатать его; arg != 0 - перед ним выводится пробел
+    PrintEnd,       // завершить команду print переводом строки, положить None
+    ExecStatement,  // выполнить AST-узел statements[arg] деревом, результат - на стек
+    Return,         // завершить выполнение фрагмента со значением с вершины стека
+};
+
+struct Instruction {
+    Op op;
+    std::uint32_t arg = 0;
+};
+
+// Плоский фрагмент байт-кода вместе с пулами констант, имён и
+// AST-узлов, исполняемых в режиме обхода дерева
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<runtime::ObjectHolder> constants;
+    std::vector<runtime::Symbol> names;
+    std::vector<CompareFn> compares;
+    std::vector<runtime::Executable*> statements;
+    // Точки обращения к полям для LoadField/StoreField; mutable - инструкции
+    // кэшируют в них позицию поля при выполнении (см. runtime::FieldSite)
+    mutable std::vector<runtime::FieldSite> field_sites;
+    // Точки обращения LoadName, параллельны names (см. runtime::NameSite)
+    mutable std::vector<runtime::NameSite> name_sites;
+};
+
+// Транслирует AST в байт-код. Узлы, умеющие компилироваться, переопределяют
+// Executable::Compile и генерируют инструкции через методы этого класса.
+// Для остальных генерируется инструкция ExecStatement, выполняющая узел деревом
+class Compiler {
+public:
+    // Компилирует узел node так, чтобы после выполнения его кода
+    // на стеке оказалось ровно одно значение - результат узла
+    void CompileNode(runtime::Executable& node);
+
+    std::uint32_t AddConstant(runtime::ObjectHolder value);
+    std::uint32_t AddName(runtime::Symbol name);
+    std::uint32_t AddCompare(CompareFn fn);
+    std::uint32_t AddFieldSite(runtime::Symbol name);
+
+    void Emit(Op op, std::uint32_t arg = 0);
+
+    // Генерирует инструкцию перехода с незаполненным адресом
+    // и возвращает её позицию для последующего PatchJump
+    std::size_t EmitJump(Op op);
+    // Текущая позиция в коде - цель для обратных переходов циклов
+    [[nodiscard]] std::size_t CurrentPosition() const;
+    // Направляет переход, сгенерированный EmitJump, на текущую позицию
+    void PatchJump(std::size_t jump_pos);
+
+    [[nodiscard]] Chunk Release();
+
+private:
+    Chunk chunk_;
+};
+
+// Выполняет байт-код во внешнем окружении closure.
+// Возвращает значение инструкции Return либо результат последней инструкции
+runtime::ObjectHolder Run(const Chunk& chunk, runtime::Closure& closure,
+                          runtime::Context& context);
+
+// Фасад над скомпилированной программой: владеет исходным AST
+// (на него ссылаются константы и узлы, выполняемые деревом)
+// и выполняет его байт-код через обычный интерфейс Executable
+class Program : public runtime::Executable {
+public:
+    explicit Program(std::unique_ptr<runtime::Executable> root);
+
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+private:
+    std::unique_ptr<runtime::Executable> root_;
+    Chunk chunk_;
+};
+
+}  // namespace vm